@@ -0,0 +1,102 @@
+// codeshaunted - apparition
+// include/apparition/command_buffer.hh
+// contains command buffer declarations
+// Copyright 2024 codeshaunted
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org / licenses / LICENSE - 2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissionsand
+// limitations under the License.
+
+#ifndef APPARITION_COMMAND_BUFFER_HH
+#define APPARITION_COMMAND_BUFFER_HH
+
+#include <functional>
+#include <vector>
+
+#include "renderer.hh"
+
+namespace apparition {
+
+// records state changes and draws for Renderer::submit, separate command buffers can be
+// recorded on separate threads, shaders are copied when recorded while buffers are only
+// referenced and have to stay alive until the command buffer is submitted, every command
+// buffer starts from the state the renderer had when submit was called
+class CommandBuffer {
+    public:
+        void setDepthFunction(DepthFunction depth_function);
+        void setDepthWrite(bool depth_write);
+        void setVertexLayout(VertexLayout vertex_layout);
+        void setViewport(Viewport viewport);
+        void setCullMode(CullMode cull_mode);
+        void setFrontFace(FrontFace front_face);
+        void setLineMode(LineMode line_mode);
+        void bindFrameBuffer(FrameBuffer* to_bind);
+        void bindVertexBuffer(std::vector<Vertex>* to_bind);
+        void bindIndexBuffer(std::vector<uint16_t>* to_bind);
+        void bindIndexBuffer(std::vector<uint32_t>* to_bind);
+        void bindIndexBuffer(std::vector<size_t>* to_bind);
+        void unbindIndexBuffer();
+        void clear(Vector4f color, float depth = 1.0f);
+        void resolve(ColorBuffer* destination);
+        template<ShaderProgram S> void drawLines(S& shader, LineTopology topology = LineTopology::LIST);
+        template<ShaderProgram S> void drawTris(S& shader, TriTopology topology = TriTopology::LIST);
+        template<ShaderProgram S> void drawLinesInstanced(S& shader, size_t instance_count, std::vector<Instance>* instance_buffer, LineTopology topology = LineTopology::LIST);
+        template<ShaderProgram S> void drawTrisInstanced(S& shader, size_t instance_count, std::vector<Instance>* instance_buffer, TriTopology topology = TriTopology::LIST);
+        size_t getCommandCount();
+        void reset();
+    private:
+        friend class Renderer;
+        std::vector<std::function<void(Renderer&)>> commands;
+};
+
+template<ShaderProgram S>
+void CommandBuffer::drawLines(S& shader, LineTopology topology) {
+    this->commands.push_back([shader, topology](Renderer& renderer) mutable {
+        Instance instance;
+        renderer.queueLines(shader, topology, &instance, 1);
+    });
+}
+
+template<ShaderProgram S>
+void CommandBuffer::drawTris(S& shader, TriTopology topology) {
+    this->commands.push_back([shader, topology](Renderer& renderer) mutable {
+        Instance instance;
+        renderer.queueTris(shader, topology, &instance, 1);
+    });
+}
+
+template<ShaderProgram S>
+void CommandBuffer::drawLinesInstanced(S& shader, size_t instance_count, std::vector<Instance>* instance_buffer, LineTopology topology) {
+    if (!instance_buffer) {
+        throw std::invalid_argument("'instance_buffer' cannot be nullptr");
+    }
+
+    this->commands.push_back([shader, instance_count, instance_buffer, topology](Renderer& renderer) mutable {
+        renderer.checkInstances(instance_count, instance_buffer);
+        renderer.queueLines(shader, topology, instance_buffer->data(), instance_count);
+    });
+}
+
+template<ShaderProgram S>
+void CommandBuffer::drawTrisInstanced(S& shader, size_t instance_count, std::vector<Instance>* instance_buffer, TriTopology topology) {
+    if (!instance_buffer) {
+        throw std::invalid_argument("'instance_buffer' cannot be nullptr");
+    }
+
+    this->commands.push_back([shader, instance_count, instance_buffer, topology](Renderer& renderer) mutable {
+        renderer.checkInstances(instance_count, instance_buffer);
+        renderer.queueTris(shader, topology, instance_buffer->data(), instance_count);
+    });
+}
+
+} // namespace apparition
+
+#endif // APPARITION_COMMAND_BUFFER_HH
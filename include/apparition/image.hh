@@ -0,0 +1,92 @@
+// codeshaunted - apparition
+// include/apparition/image.hh
+// contains image encoder declarations
+// Copyright 2024 codeshaunted
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org / licenses / LICENSE - 2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissionsand
+// limitations under the License.
+
+#ifndef APPARITION_IMAGE_HH
+#define APPARITION_IMAGE_HH
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "renderer.hh"
+
+namespace apparition {
+
+// 8-bit encodings of color buffers, tga keeps alpha and is limited to 65535 pixels on either
+// side, ppm drops alpha and png keeps it
+enum class ImageFormat {
+    TGA,
+    TGA_RLE,
+    PPM,
+    PNG
+};
+
+// zlib stream compressor, greedy lz77 matches over a 32 KiB window coded with the fixed huffman
+// tables of deflate, favoring speed over size, input can be fed in pieces of any size
+class Deflater {
+    public:
+        Deflater();
+        void compress(const uint8_t* data, size_t size, std::vector<uint8_t>& output);
+        void finish(std::vector<uint8_t>& output);
+    private:
+        void encode(size_t end, std::vector<uint8_t>& output);
+        void writeBits(uint32_t bits, uint32_t count, std::vector<uint8_t>& output);
+        void writeLiteral(uint32_t literal, std::vector<uint8_t>& output);
+        void writeMatch(uint32_t length, uint32_t distance, std::vector<uint8_t>& output);
+        std::vector<uint8_t> window;
+        std::vector<size_t> head;
+        size_t window_start;
+        size_t position;
+        uint64_t bit_buffer;
+        uint32_t bit_count;
+        uint32_t adler_a;
+        uint32_t adler_b;
+};
+
+// encodes an image row by row from the top, which is the last row of a color buffer, so a
+// frame can be written out in bands as they are rendered or while the next frame renders into
+// another buffer, rows are converted in blocks and the file is written in large blocks
+class ImageWriter {
+    public:
+        ImageWriter(const std::string& path, Vector2u dimensions, ImageFormat format);
+        Vector2u getDimensions();
+        uint32_t getRemainingRows();
+        void writeRows(ColorBuffer* color_buffer, uint32_t row_count);
+        void finish();
+    private:
+        void encodeRow();
+        void writeChunk(const char* type, const uint8_t* data, size_t size);
+        void flush();
+        std::ofstream file;
+        Vector2u dimensions;
+        ImageFormat format;
+        uint32_t next_row;
+        bool finished;
+        std::vector<uint8_t> row;
+        std::vector<uint8_t> previous_row;
+        std::vector<uint8_t> output;
+        std::vector<uint8_t> compressed;
+        Deflater deflater;
+};
+
+// writes a whole color buffer, multisampled buffers are resolved on the way out
+void saveImage(const std::string& path, ColorBuffer* color_buffer, ImageFormat format);
+
+} // namespace apparition
+
+#endif // APPARITION_IMAGE_HH
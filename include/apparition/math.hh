@@ -19,38 +19,75 @@
 #define APPARITION_MATH_HH
 
 #include <cmath>
+#include <cstdint>
 #include <expected>
 #include <initializer_list>
 #include <stdexcept>
+#include <type_traits>
+
+#include "simd.hh"
 
 namespace apparition {
 
+// component storage for vectors, the small sizes alias their elements with named
+// components through anonymous unions instead of per-instance reference members
 template<typename T, size_t N>
-class Vector {
+struct VectorStorage {
+    T data[N];
+};
+
+template<typename T>
+struct VectorStorage<T, 2> {
+    union {
+        T data[2];
+        struct { T x, y; };
+    };
+};
+
+template<typename T>
+struct VectorStorage<T, 3> {
+    union {
+        T data[3];
+        struct { T x, y, z; };
+        struct { T r, g, b; };
+    };
+};
+
+template<typename T>
+struct alignas(4 * sizeof(T)) VectorStorage<T, 4> {
+    union {
+        T data[4];
+        struct { T x, y, z, w; };
+        struct { T r, g, b, a; };
+    };
+};
+
+template<typename T, size_t N>
+class Vector : public VectorStorage<T, N> {
     public:
         Vector();
         Vector(std::initializer_list<T> data);
+        template<typename... Args> requires (sizeof...(Args) == N && N > 1 && (std::is_convertible_v<Args, T> && ...))
+        Vector(Args... components);
         T& get(size_t i);
+        const T& get(size_t i) const;
         T& operator[](size_t i);
-        T length();
-        T dot(Vector<T, N>& other);
-        Vector<T, N> scale(T scalar);
-        Vector<T, N> operator*(T scalar);
-        Vector<T, N> add(Vector<T, N>& addend);
-        Vector<T, N> operator+(Vector<T, N>& addend);
-        Vector<T, N> subtract(Vector<T, N>& subtrahend);
-        Vector<T, N> operator-(Vector<T, N>& subtrahend);
-    protected:
-        T data[N];
+        const T& operator[](size_t i) const;
+        T length() const;
+        T dot(const Vector<T, N>& other) const;
+        Vector<T, N> scale(T scalar) const;
+        Vector<T, N> operator*(T scalar) const;
+        Vector<T, N> add(const Vector<T, N>& addend) const;
+        Vector<T, N> operator+(const Vector<T, N>& addend) const;
+        Vector<T, N> subtract(const Vector<T, N>& subtrahend) const;
+        Vector<T, N> operator-(const Vector<T, N>& subtrahend) const;
+        Vector<T, N> cross(const Vector<T, N>& other) const requires (N == 3);
 };
 
 template<typename T, size_t N>
 Vector<T, N>::Vector() {
     static_assert(std::is_arithmetic_v<T>, "'T' must be an arithmetic type");
-
-    if (N <= 0) {
-        throw std::invalid_argument("Invalid number of elements");
-    }
+    static_assert(N > 0, "Invalid number of elements");
 
     for (size_t j = 0; j < N; ++j) {
         this->data[j] = 0;
@@ -70,9 +107,25 @@ Vector<T, N>::Vector(std::initializer_list<T> data) {
     }
 }
 
+template<typename T, size_t N>
+template<typename... Args> requires (sizeof...(Args) == N && N > 1 && (std::is_convertible_v<Args, T> && ...))
+Vector<T, N>::Vector(Args... components) {
+    size_t i = 0;
+    ((this->data[i++] = static_cast<T>(components)), ...);
+}
+
 template<typename T, size_t N>
 T& Vector<T, N>::get(size_t i) {
-    if (i < 0 || i >= N) {
+    if (i >= N) {
+        throw std::out_of_range("Value for 'i' is out of range");
+    }
+
+    return this->data[i];
+}
+
+template<typename T, size_t N>
+const T& Vector<T, N>::get(size_t i) const {
+    if (i >= N) {
         throw std::out_of_range("Value for 'i' is out of range");
     }
 
@@ -84,18 +137,18 @@ T& Vector<T, N>::operator[](size_t i) {
     return this->get(i);
 }
 
-template <typename T, size_t N>
-T Vector<T, N>::length() {
-    T squares_sum = 0;
-    for (size_t i = 0; i < N; ++i) {
-        squares_sum += this->data[i] * this->data[i];
-    }
+template<typename T, size_t N>
+const T& Vector<T, N>::operator[](size_t i) const {
+    return this->get(i);
+}
 
-    return std::sqrt(squares_sum);
+template <typename T, size_t N>
+T Vector<T, N>::length() const {
+    return std::sqrt(this->dot(*this));
 }
 
 template<typename T, size_t N>
-T Vector<T, N>::dot(Vector<T, N>& other) {
+T Vector<T, N>::dot(const Vector<T, N>& other) const {
     T product = 0;
 
     for (size_t i = 0; i < N; ++i) {
@@ -106,96 +159,56 @@ T Vector<T, N>::dot(Vector<T, N>& other) {
 }
 
 template<typename T, size_t N>
-Vector<T, N> Vector<T, N>::scale(T scalar) {
+Vector<T, N> Vector<T, N>::scale(T scalar) const {
     Vector<T, N> result;
 
     for (size_t i = 0; i < N; ++i) {
-        result[i] = this->data[i] * scalar;
+        result.data[i] = this->data[i] * scalar;
     }
 
     return result;
 }
 
 template<typename T, size_t N>
-Vector<T, N> Vector<T, N>::operator*(T scalar) {
+Vector<T, N> Vector<T, N>::operator*(T scalar) const {
     return this->scale(scalar);
 }
 
 template<typename T, size_t N>
-Vector<T, N> Vector<T, N>::add(Vector<T, N>& addend) {
+Vector<T, N> Vector<T, N>::add(const Vector<T, N>& addend) const {
     Vector<T, N> result;
 
     for (size_t i = 0; i < N; ++i) {
-        result[i] = this->data[i] + addend[i];
+        result.data[i] = this->data[i] + addend.data[i];
     }
 
     return result;
 }
 
 template<typename T, size_t N>
-Vector<T, N> Vector<T, N>::operator+(Vector<T, N>& addend) {
+Vector<T, N> Vector<T, N>::operator+(const Vector<T, N>& addend) const {
     return this->add(addend);
 }
 
 template<typename T, size_t N>
-Vector<T, N> Vector<T, N>::subtract(Vector<T, N>& subtrahend) {
-    Vector<T, N> negative = subtrahend.scale(-1);
-    return this->add(negative);
-}
-
-template<typename T, size_t N>
-Vector<T, N> Vector<T, N>::operator-(Vector<T, N>& subtrahend) {
-    return this->subtract(subtrahend);
-}
-
-template<typename T>
-class Vector2 : public Vector<T, 2> {
-    public:
-        T& x = Vector<T, 2>::data[0];
-        T& y = Vector<T, 2>::data[1];
-        Vector2() : Vector<T, 2>() {}
-        Vector2(T _x, T _y) : Vector<T, 2>({_x, _y}) {}
-        Vector2(const Vector<T, 2>& other) : Vector<T, 2>(other) {}
-        Vector2<T>& operator=(const Vector2<T>& other);
-};
+Vector<T, N> Vector<T, N>::subtract(const Vector<T, N>& subtrahend) const {
+    Vector<T, N> result;
 
-template<typename T>
-Vector2<T>& Vector2<T>::operator=(const Vector2<T>& other) {
-    if (this != &other) {
-        Vector<T, 2>::operator=(other);
+    for (size_t i = 0; i < N; ++i) {
+        result.data[i] = this->data[i] - subtrahend.data[i];
     }
 
-    return *this;
+    return result;
 }
 
-template<typename T>
-class Vector3 : public Vector<T, 3> {
-    public:
-        T& x = Vector<T, 3>::data[0];
-        T& y = Vector<T, 3>::data[1];
-        T& z = Vector<T, 3>::data[2];
-        T& r = Vector<T, 3>::data[0];
-        T& g = Vector<T, 3>::data[1];
-        T& b = Vector<T, 3>::data[2];
-        Vector3() : Vector<T, 3>() {}
-        Vector3(T _x, T _y, T _z) : Vector<T, 3>({_x, _y, _z}) {}
-        Vector3<T> cross(Vector3<T>& other);
-        Vector3(const Vector<T, 3>& other) : Vector<T, 3>(other) {}
-        Vector3<T>& operator=(const Vector3<T>& other);
-};
-
-template<typename T>
-Vector3<T>& Vector3<T>::operator=(const Vector3<T>& other) {
-    if (this != &other) {
-        Vector<T, 3>::operator=(other);
-    }
-
-    return *this;
+template<typename T, size_t N>
+Vector<T, N> Vector<T, N>::operator-(const Vector<T, N>& subtrahend) const {
+    return this->subtract(subtrahend);
 }
 
-template<typename T>
-Vector3<T> Vector3<T>::cross(Vector3<T>& other) {
-    Vector3<T> result;
+template<typename T, size_t N>
+Vector<T, N> Vector<T, N>::cross(const Vector<T, N>& other) const requires (N == 3) {
+    Vector<T, N> result;
     result.x = this->y * other.z - this->z * other.y;
     result.y = this->z * other.x - this->x * other.z;
     result.z = this->x * other.y - this->y * other.x;
@@ -203,37 +216,25 @@ Vector3<T> Vector3<T>::cross(Vector3<T>& other) {
 }
 
 template<typename T>
-class Vector4 : public Vector<T, 4> {
-    public:
-        T& x = Vector<T, 4>::data[0];
-        T& y = Vector<T, 4>::data[1];
-        T& z = Vector<T, 4>::data[2];
-        T& w = Vector<T, 4>::data[3];
-        T& r = Vector<T, 4>::data[0];
-        T& g = Vector<T, 4>::data[1];
-        T& b = Vector<T, 4>::data[2];
-        T& a = Vector<T, 4>::data[3];
-        Vector4() : Vector<T, 4>() {}
-        Vector4(T _x, T _y, T _z, T _w) : Vector<T, 4>({_x, _y, _z, _w}) {}
-        Vector4(const Vector<T, 4>& other) : Vector<T, 4>(other) {}
-        Vector4<T>& operator=(const Vector4<T>& other);
-};
+using Vector2 = Vector<T, 2>;
 
 template<typename T>
-Vector4<T>& Vector4<T>::operator=(const Vector4<T>& other) {
-    if (this != &other) {
-        Vector<T, 4>::operator=(other);
-    }
+using Vector3 = Vector<T, 3>;
 
-    return *this;
-}
+template<typename T>
+using Vector4 = Vector<T, 4>;
 
+// rows of four are aligned like Vector<T, 4> so they can be loaded as one register
 template<typename T, size_t C>
-class MatrixRow {
+class alignas(C == 4 ? 4 * sizeof(T) : alignof(T)) MatrixRow {
     public:
         MatrixRow();
         T& getColumn(size_t j);
+        const T& getColumn(size_t j) const;
         T& operator[](size_t j);
+        const T& operator[](size_t j) const;
+        T* getData();
+        const T* getData() const;
     private:
         T columns[C];
 };
@@ -241,10 +242,7 @@ class MatrixRow {
 template<typename T, size_t C>
 MatrixRow<T, C>::MatrixRow() {
     static_assert(std::is_arithmetic_v<T>, "'T' must be an arithmetic type");
-
-    if (C <= 0) {
-        throw std::invalid_argument("Invalid number of columns");
-    }
+    static_assert(C > 0, "Invalid number of columns");
 
     for (size_t j = 0; j < C; ++j) {
         this->columns[j] = 0;
@@ -253,7 +251,16 @@ MatrixRow<T, C>::MatrixRow() {
 
 template<typename T, size_t C>
 T& MatrixRow<T, C>::getColumn(size_t j) {
-    if (j < 0 || j >= C) {
+    if (j >= C) {
+        throw std::out_of_range("Value for 'j' is out of range");
+    }
+
+    return this->columns[j];
+}
+
+template<typename T, size_t C>
+const T& MatrixRow<T, C>::getColumn(size_t j) const {
+    if (j >= C) {
         throw std::out_of_range("Value for 'j' is out of range");
     }
 
@@ -265,6 +272,21 @@ T& MatrixRow<T, C>::operator[](size_t j) {
     return this->getColumn(j);
 }
 
+template<typename T, size_t C>
+const T& MatrixRow<T, C>::operator[](size_t j) const {
+    return this->getColumn(j);
+}
+
+template<typename T, size_t C>
+T* MatrixRow<T, C>::getData() {
+    return this->columns;
+}
+
+template<typename T, size_t C>
+const T* MatrixRow<T, C>::getData() const {
+    return this->columns;
+}
+
 template<typename T, size_t R, size_t C>
 class Matrix {
     public:
@@ -274,29 +296,31 @@ class Matrix {
         Matrix();
         Matrix(std::initializer_list<std::initializer_list<T>> data);
         static Matrix<T, R, C> identity();
-        T get(size_t i, size_t j);
+        T get(size_t i, size_t j) const;
         MatrixRow<T, C>& getRow(size_t i);
+        const MatrixRow<T, C>& getRow(size_t i) const;
         MatrixRow<T, C>& operator[](size_t i);
-        template<size_t N> Matrix<T, R, N> multiply(Matrix<T, C, N>& other);
-        Vector<T, C> multiply(Vector<T, C>& other);
-        Matrix<T, C, R> transpose();
-        Matrix<T, R, C> rowReduce();
-        Matrix<T, R - 1, C - 1> minors(size_t i, size_t j);
-        T minor(size_t i, size_t j);
-        T cofactor(size_t i, size_t j);
-        Matrix<T, R, C> cofactors();
-        Matrix<T, R, C> adjugate();
-        std::expected<Matrix<T, R, C>, Error> inverse();
-        T determinant();
+        const MatrixRow<T, C>& operator[](size_t i) const;
+        template<size_t N> Matrix<T, R, N> multiply(const Matrix<T, C, N>& other) const;
+        Vector<T, R> multiply(const Vector<T, C>& other) const;
+        Matrix<T, C, R> transpose() const;
+        Matrix<T, R, C> rowReduce() const;
+        Matrix<T, R - 1, C - 1> minors(size_t i, size_t j) const;
+        T minor(size_t i, size_t j) const;
+        T cofactor(size_t i, size_t j) const;
+        Matrix<T, R, C> cofactors() const;
+        Matrix<T, R, C> adjugate() const;
+        std::expected<Matrix<T, R, C>, Error> inverse() const;
+        std::expected<Matrix<T, R, C>, Error> affineInverse() const;
+        T determinant() const;
     private:
+        void subDeterminants(T upper[6], T lower[6]) const;
         MatrixRow<T, C> rows[R];
 };
 
 template<typename T, size_t R, size_t C>
 Matrix<T, R, C>::Matrix() {
-    if (R <= 0) {
-        throw std::invalid_argument("Invalid number of columns");
-    }
+    static_assert(R > 0, "Invalid number of rows");
 }
 
 template<typename T, size_t R, size_t C>
@@ -333,13 +357,22 @@ Matrix<T, R, C> Matrix<T, R, C>::identity() {
 }
 
 template<typename T, size_t R, size_t C>
-T Matrix<T, R, C>::get(size_t i, size_t j) {
-    return this->getRow(i)->getColumn(j);
+T Matrix<T, R, C>::get(size_t i, size_t j) const {
+    return this->getRow(i).getColumn(j);
 }
 
 template<typename T, size_t R, size_t C>
 MatrixRow<T, C>& Matrix<T, R, C>::getRow(size_t i) {
-    if (i < 0 || i >= R) {
+    if (i >= R) {
+        throw std::out_of_range("Value for 'i' is out of range");
+    }
+
+    return this->rows[i];
+}
+
+template<typename T, size_t R, size_t C>
+const MatrixRow<T, C>& Matrix<T, R, C>::getRow(size_t i) const {
+    if (i >= R) {
         throw std::out_of_range("Value for 'i' is out of range");
     }
 
@@ -351,9 +384,14 @@ MatrixRow<T, C>& Matrix<T, R, C>::operator[](size_t i) {
     return this->getRow(i);
 }
 
+template<typename T, size_t R, size_t C>
+const MatrixRow<T, C>& Matrix<T, R, C>::operator[](size_t i) const {
+    return this->getRow(i);
+}
+
 template<typename T, size_t R, size_t C>
 template<size_t N>
-Matrix<T, R, N> Matrix<T, R, C>::multiply(Matrix<T, C, N>& other) {
+Matrix<T, R, N> Matrix<T, R, C>::multiply(const Matrix<T, C, N>& other) const {
     Matrix<T, R, N> result;
 
     for (size_t i = 0; i < R; ++i) {
@@ -370,22 +408,22 @@ Matrix<T, R, N> Matrix<T, R, C>::multiply(Matrix<T, C, N>& other) {
 }
 
 template<typename T, size_t R, size_t C>
-Vector<T, C> Matrix<T, R, C>::multiply(Vector<T, C>& other) {
-    Vector<T, C> result;
+Vector<T, R> Matrix<T, R, C>::multiply(const Vector<T, C>& other) const {
+    Vector<T, R> result;
 
     for (size_t i = 0; i < R; ++i) {
         T sum = 0;
         for (size_t j = 0; j < C; ++j) {
-            sum += this->rows[i][j] * other[j];
+            sum += this->rows[i][j] * other.data[j];
         }
-        result[i] = sum;
+        result.data[i] = sum;
     }
 
     return result;
 }
 
 template<typename T, size_t R, size_t C>
-Matrix<T, C, R> Matrix<T, R, C>::transpose() {
+Matrix<T, C, R> Matrix<T, R, C>::transpose() const {
     Matrix<T, C, R> transposed;
 
     for (size_t i = 0; i < R; ++i) {
@@ -398,7 +436,7 @@ Matrix<T, C, R> Matrix<T, R, C>::transpose() {
 }
 
 template<typename T, size_t R, size_t C>
-Matrix<T, R, C> Matrix<T, R, C>::rowReduce() {
+Matrix<T, R, C> Matrix<T, R, C>::rowReduce() const {
     Matrix<T, R, C> result = *this;
 
     size_t lead = 0;
@@ -447,7 +485,7 @@ Matrix<T, R, C> Matrix<T, R, C>::rowReduce() {
 }
 
 template<typename T, size_t R, size_t C>
-Matrix<T, R - 1, C - 1> Matrix<T, R, C>::minors(size_t i, size_t j) {
+Matrix<T, R - 1, C - 1> Matrix<T, R, C>::minors(size_t i, size_t j) const {
     static_assert(R == C, "Minors are only defined for square matrices");
 
     Matrix<T, R - 1, C - 1> minors;
@@ -468,14 +506,14 @@ Matrix<T, R - 1, C - 1> Matrix<T, R, C>::minors(size_t i, size_t j) {
 }
 
 template<typename T, size_t R, size_t C>
-T Matrix<T, R, C>::minor(size_t i, size_t j) {
+T Matrix<T, R, C>::minor(size_t i, size_t j) const {
     static_assert(R == C, "Minor is only defined for square matrices");
 
     return this->minors(i, j).determinant();
 }
 
 template<typename T, size_t R, size_t C>
-T Matrix<T, R, C>::cofactor(size_t i, size_t j) {
+T Matrix<T, R, C>::cofactor(size_t i, size_t j) const {
     static_assert(R == C, "Cofactor is only defined for square matrices");
 
     T minor = this->minor(i, j);
@@ -484,7 +522,7 @@ T Matrix<T, R, C>::cofactor(size_t i, size_t j) {
 }
 
 template<typename T, size_t R, size_t C>
-Matrix<T, R, C> Matrix<T, R, C>::cofactors() {
+Matrix<T, R, C> Matrix<T, R, C>::cofactors() const {
     static_assert(R == C, "Cofactors are only defined for square matrices");
 
     Matrix<T, R, C> result;
@@ -498,30 +536,98 @@ Matrix<T, R, C> Matrix<T, R, C>::cofactors() {
 }
 
 template<typename T, size_t R, size_t C>
-Matrix<T, R, C> Matrix<T, R, C>::adjugate() {
+Matrix<T, R, C> Matrix<T, R, C>::adjugate() const {
     static_assert(R == C, "Adjugate is only defined for square matrices");
 
     return this->cofactors().transpose();
 }
 
 template<typename T, size_t R, size_t C>
-std::expected<Matrix<T, R, C>, typename Matrix<T, R, C>::Error> Matrix<T, R, C>::inverse() {
+std::expected<Matrix<T, R, C>, typename Matrix<T, R, C>::Error> Matrix<T, R, C>::inverse() const {
     static_assert(R == C, "Inverse is only defined for square matrices");
 
-    T det = this->determinant();
+    Matrix<T, R, C> inverse;
 
-    // check if the determinant is zero, if so, matrix is not invertible
-    if (det == 0) {
-        return std::unexpected(Error::INVERSE_MATRIX_DOES_NOT_EXIST);
-    }
+    if constexpr (R == 3) {
+        const T* m0 = this->rows[0].getData();
+        const T* m1 = this->rows[1].getData();
+        const T* m2 = this->rows[2].getData();
 
-    Matrix<T, R, C> inverse;
-    Matrix<T, R, C> adjugate = this->adjugate();
+        // closed-form adjugate, the first column doubles as the cofactor expansion of the determinant
+        T a00 = (m1[1] * m2[2]) - (m1[2] * m2[1]);
+        T a10 = (m1[2] * m2[0]) - (m1[0] * m2[2]);
+        T a20 = (m1[0] * m2[1]) - (m1[1] * m2[0]);
 
-    // calculate the inverse by dividing the adjugate by the determinant
-    for (size_t i = 0; i < R; ++i) {
-        for (size_t j = 0; j < C; ++j) {
-            inverse[i][j] = adjugate[i][j] / det;
+        T det = (m0[0] * a00) + (m0[1] * a10) + (m0[2] * a20);
+        if (det == 0) {
+            return std::unexpected(Error::INVERSE_MATRIX_DOES_NOT_EXIST);
+        }
+
+        T inverse_det = 1 / det;
+        T* i0 = inverse.rows[0].getData();
+        T* i1 = inverse.rows[1].getData();
+        T* i2 = inverse.rows[2].getData();
+        i0[0] = a00 * inverse_det;
+        i0[1] = ((m0[2] * m2[1]) - (m0[1] * m2[2])) * inverse_det;
+        i0[2] = ((m0[1] * m1[2]) - (m0[2] * m1[1])) * inverse_det;
+        i1[0] = a10 * inverse_det;
+        i1[1] = ((m0[0] * m2[2]) - (m0[2] * m2[0])) * inverse_det;
+        i1[2] = ((m0[2] * m1[0]) - (m0[0] * m1[2])) * inverse_det;
+        i2[0] = a20 * inverse_det;
+        i2[1] = ((m0[1] * m2[0]) - (m0[0] * m2[1])) * inverse_det;
+        i2[2] = ((m0[0] * m1[1]) - (m0[1] * m1[0])) * inverse_det;
+    } else if constexpr (R == 4) {
+        const T* m0 = this->rows[0].getData();
+        const T* m1 = this->rows[1].getData();
+        const T* m2 = this->rows[2].getData();
+        const T* m3 = this->rows[3].getData();
+
+        // closed-form adjugate built from the 2x2 determinants of the upper and lower row pairs
+        T s[6];
+        T c[6];
+        this->subDeterminants(s, c);
+
+        T det = (s[0] * c[5]) - (s[1] * c[4]) + (s[2] * c[3]) + (s[3] * c[2]) - (s[4] * c[1]) + (s[5] * c[0]);
+        if (det == 0) {
+            return std::unexpected(Error::INVERSE_MATRIX_DOES_NOT_EXIST);
+        }
+
+        T inverse_det = 1 / det;
+        T* i0 = inverse.rows[0].getData();
+        T* i1 = inverse.rows[1].getData();
+        T* i2 = inverse.rows[2].getData();
+        T* i3 = inverse.rows[3].getData();
+        i0[0] = ((m1[1] * c[5]) - (m1[2] * c[4]) + (m1[3] * c[3])) * inverse_det;
+        i0[1] = (-(m0[1] * c[5]) + (m0[2] * c[4]) - (m0[3] * c[3])) * inverse_det;
+        i0[2] = ((m3[1] * s[5]) - (m3[2] * s[4]) + (m3[3] * s[3])) * inverse_det;
+        i0[3] = (-(m2[1] * s[5]) + (m2[2] * s[4]) - (m2[3] * s[3])) * inverse_det;
+        i1[0] = (-(m1[0] * c[5]) + (m1[2] * c[2]) - (m1[3] * c[1])) * inverse_det;
+        i1[1] = ((m0[0] * c[5]) - (m0[2] * c[2]) + (m0[3] * c[1])) * inverse_det;
+        i1[2] = (-(m3[0] * s[5]) + (m3[2] * s[2]) - (m3[3] * s[1])) * inverse_det;
+        i1[3] = ((m2[0] * s[5]) - (m2[2] * s[2]) + (m2[3] * s[1])) * inverse_det;
+        i2[0] = ((m1[0] * c[4]) - (m1[1] * c[2]) + (m1[3] * c[0])) * inverse_det;
+        i2[1] = (-(m0[0] * c[4]) + (m0[1] * c[2]) - (m0[3] * c[0])) * inverse_det;
+        i2[2] = ((m3[0] * s[4]) - (m3[1] * s[2]) + (m3[3] * s[0])) * inverse_det;
+        i2[3] = (-(m2[0] * s[4]) + (m2[1] * s[2]) - (m2[3] * s[0])) * inverse_det;
+        i3[0] = (-(m1[0] * c[3]) + (m1[1] * c[1]) - (m1[2] * c[0])) * inverse_det;
+        i3[1] = ((m0[0] * c[3]) - (m0[1] * c[1]) + (m0[2] * c[0])) * inverse_det;
+        i3[2] = (-(m3[0] * s[3]) + (m3[1] * s[1]) - (m3[2] * s[0])) * inverse_det;
+        i3[3] = ((m2[0] * s[3]) - (m2[1] * s[1]) + (m2[2] * s[0])) * inverse_det;
+    } else {
+        T det = this->determinant();
+
+        // check if the determinant is zero, if so, matrix is not invertible
+        if (det == 0) {
+            return std::unexpected(Error::INVERSE_MATRIX_DOES_NOT_EXIST);
+        }
+
+        Matrix<T, R, C> adjugate = this->adjugate();
+
+        // calculate the inverse by dividing the adjugate by the determinant
+        for (size_t i = 0; i < R; ++i) {
+            for (size_t j = 0; j < C; ++j) {
+                inverse[i][j] = adjugate[i][j] / det;
+            }
         }
     }
 
@@ -529,61 +635,135 @@ std::expected<Matrix<T, R, C>, typename Matrix<T, R, C>::Error> Matrix<T, R, C>:
 }
 
 template<typename T, size_t R, size_t C>
-T Matrix<T, R, C>::determinant() {
-    static_assert(R == C, "The determinant is only defined for square matrices");
+std::expected<Matrix<T, R, C>, typename Matrix<T, R, C>::Error> Matrix<T, R, C>::affineInverse() const {
+    static_assert(R == 4 && C == 4, "The affine inverse is only defined for 4x4 matrices");
+
+    // assumes a bottom row of (0, 0, 0, 1), only the linear 3x3 block needs a real inverse
+    // and the translation is carried back through it
+    Matrix<T, 3, 3> linear;
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < 3; ++j) {
+            linear[i].getData()[j] = this->rows[i].getData()[j];
+        }
+    }
 
-    Matrix<T, R, C> reduction = *this;
-    float determinant = 1.0f;
+    std::expected<Matrix<T, 3, 3>, typename Matrix<T, 3, 3>::Error> linear_inverse = linear.inverse();
+    if (!linear_inverse) {
+        return std::unexpected(Error::INVERSE_MATRIX_DOES_NOT_EXIST);
+    }
 
-    size_t lead = 0;
-    for (size_t r = 0; r < R; ++r) {
-        if (C <= lead)
-            break;
+    Matrix<T, R, C> inverse = Matrix<T, R, C>::identity();
+    for (size_t i = 0; i < 3; ++i) {
+        const T* linear_row = (*linear_inverse)[i].getData();
+        T* row = inverse.rows[i].getData();
+        row[0] = linear_row[0];
+        row[1] = linear_row[1];
+        row[2] = linear_row[2];
+        row[3] = -((linear_row[0] * this->rows[0].getData()[3]) + (linear_row[1] * this->rows[1].getData()[3]) + (linear_row[2] * this->rows[2].getData()[3]));
+    }
 
-        size_t i = r;
-        while (reduction[i][lead] == 0) {
-            ++i;
-            if (R == i) {
-                i = r;
-                ++lead;
-                if (C == lead)
-                    break;
-            }
-        }
+    return inverse;
+}
 
-        if (C == lead)
-            break;
+template<typename T, size_t R, size_t C>
+T Matrix<T, R, C>::determinant() const {
+    static_assert(R == C, "The determinant is only defined for square matrices");
 
-        if (i != r) {
-            std::swap(reduction[i], reduction[r]);
-            determinant *= -1.0f;
-        }
+    if constexpr (R == 1) {
+        return this->rows[0].getData()[0];
+    } else if constexpr (R == 2) {
+        const T* m0 = this->rows[0].getData();
+        const T* m1 = this->rows[1].getData();
+        return (m0[0] * m1[1]) - (m0[1] * m1[0]);
+    } else if constexpr (R == 3) {
+        const T* m0 = this->rows[0].getData();
+        const T* m1 = this->rows[1].getData();
+        const T* m2 = this->rows[2].getData();
+        return (m0[0] * ((m1[1] * m2[2]) - (m1[2] * m2[1]))) - (m0[1] * ((m1[0] * m2[2]) - (m1[2] * m2[0]))) + (m0[2] * ((m1[0] * m2[1]) - (m1[1] * m2[0])));
+    } else if constexpr (R == 4) {
+        T s[6];
+        T c[6];
+        this->subDeterminants(s, c);
+        return (s[0] * c[5]) - (s[1] * c[4]) + (s[2] * c[3]) + (s[3] * c[2]) - (s[4] * c[1]) + (s[5] * c[0]);
+    } else {
+        Matrix<T, R, C> reduction = *this;
+        T determinant = 1;
+
+        size_t lead = 0;
+        for (size_t r = 0; r < R; ++r) {
+            if (C <= lead)
+                break;
+
+            size_t i = r;
+            while (reduction[i][lead] == 0) {
+                ++i;
+                if (R == i) {
+                    i = r;
+                    ++lead;
+                    if (C == lead)
+                        break;
+                }
+            }
 
-        T val = reduction[r][lead];
-        if (val != 0) {
-            for (size_t j = 0; j < C; ++j) {
-                reduction[r][j] /= val;
+            if (C == lead)
+                break;
+
+            if (i != r) {
+                std::swap(reduction[i], reduction[r]);
+                determinant = -determinant;
             }
-            determinant *= val;
-        }
 
-        for (size_t k = 0; k < R; ++k) {
-            if (k != r) {
-                T factor = reduction[k][lead];
+            T val = reduction[r][lead];
+            if (val != 0) {
                 for (size_t j = 0; j < C; ++j) {
-                    reduction[k][j] -= factor * reduction[r][j];
+                    reduction[r][j] /= val;
                 }
+                determinant *= val;
             }
+
+            for (size_t k = 0; k < R; ++k) {
+                if (k != r) {
+                    T factor = reduction[k][lead];
+                    for (size_t j = 0; j < C; ++j) {
+                        reduction[k][j] -= factor * reduction[r][j];
+                    }
+                }
+            }
+
+            ++lead;
         }
 
-        ++lead;
-    }
+        for (size_t i = 0; i < R; ++i) {
+            determinant *= reduction[i][i];
+        }
 
-    for (size_t i = 0; i < R; ++i) {
-        determinant *= reduction[i][i];
+        return determinant;
     }
+}
 
-    return determinant;
+template<typename T, size_t R, size_t C>
+void Matrix<T, R, C>::subDeterminants(T upper[6], T lower[6]) const {
+    static_assert(R == 4 && C == 4, "Sub-determinants are only defined for 4x4 matrices");
+
+    const T* m0 = this->rows[0].getData();
+    const T* m1 = this->rows[1].getData();
+    const T* m2 = this->rows[2].getData();
+    const T* m3 = this->rows[3].getData();
+
+    // 2x2 determinants of every column pair of rows 0-1 and rows 2-3
+    upper[0] = (m0[0] * m1[1]) - (m1[0] * m0[1]);
+    upper[1] = (m0[0] * m1[2]) - (m1[0] * m0[2]);
+    upper[2] = (m0[0] * m1[3]) - (m1[0] * m0[3]);
+    upper[3] = (m0[1] * m1[2]) - (m1[1] * m0[2]);
+    upper[4] = (m0[1] * m1[3]) - (m1[1] * m0[3]);
+    upper[5] = (m0[2] * m1[3]) - (m1[2] * m0[3]);
+
+    lower[0] = (m2[0] * m3[1]) - (m3[0] * m2[1]);
+    lower[1] = (m2[0] * m3[2]) - (m3[0] * m2[2]);
+    lower[2] = (m2[0] * m3[3]) - (m3[0] * m2[3]);
+    lower[3] = (m2[1] * m3[2]) - (m3[1] * m2[2]);
+    lower[4] = (m2[1] * m3[3]) - (m3[1] * m2[3]);
+    lower[5] = (m2[2] * m3[3]) - (m3[2] * m2[3]);
 }
 
 typedef Vector2<uint32_t> Vector2u;
@@ -594,6 +774,77 @@ typedef Vector4<float> Vector4f;
 typedef Matrix<float, 3, 3> Matrix3x3f;
 typedef Matrix<float, 4, 4> Matrix4x4f;
 
+// 4-wide specializations of the hot vector and matrix operations, the generic
+// templates above stay in use for every other element type and size
+
+template<>
+inline float Vector<float, 4>::dot(const Vector<float, 4>& other) const {
+    return (Float4::load(this->data) * Float4::load(other.data)).sum();
+}
+
+template<>
+inline Vector<float, 4> Vector<float, 4>::scale(float scalar) const {
+    Vector<float, 4> result;
+    (Float4::load(this->data) * Float4::broadcast(scalar)).store(result.data);
+    return result;
+}
+
+template<>
+inline Vector<float, 4> Vector<float, 4>::add(const Vector<float, 4>& addend) const {
+    Vector<float, 4> result;
+    (Float4::load(this->data) + Float4::load(addend.data)).store(result.data);
+    return result;
+}
+
+template<>
+inline Vector<float, 4> Vector<float, 4>::subtract(const Vector<float, 4>& subtrahend) const {
+    Vector<float, 4> result;
+    (Float4::load(this->data) - Float4::load(subtrahend.data)).store(result.data);
+    return result;
+}
+
+template<>
+inline Vector<float, 4> Matrix<float, 4, 4>::multiply(const Vector<float, 4>& other) const {
+    Float4 column_0 = Float4::load(this->rows[0].getData());
+    Float4 column_1 = Float4::load(this->rows[1].getData());
+    Float4 column_2 = Float4::load(this->rows[2].getData());
+    Float4 column_3 = Float4::load(this->rows[3].getData());
+    transpose4x4(column_0, column_1, column_2, column_3);
+
+    Vector<float, 4> result;
+    Float4 sum = (column_0 * Float4::broadcast(other.x)) + (column_1 * Float4::broadcast(other.y));
+    sum = sum + (column_2 * Float4::broadcast(other.z)) + (column_3 * Float4::broadcast(other.w));
+    sum.store(result.data);
+    return result;
+}
+
+template<>
+template<>
+inline Matrix<float, 4, 4> Matrix<float, 4, 4>::multiply<4>(const Matrix<float, 4, 4>& other) const {
+    Float4 other_rows[4];
+    for (size_t k = 0; k < 4; ++k) {
+        other_rows[k] = Float4::load(other.rows[k].getData());
+    }
+
+    // each result row is a combination of the other matrix's rows
+    Matrix<float, 4, 4> result;
+    for (size_t i = 0; i < 4; ++i) {
+        const float* row = this->rows[i].getData();
+        Float4 sum = (other_rows[0] * Float4::broadcast(row[0])) + (other_rows[1] * Float4::broadcast(row[1]));
+        sum = sum + (other_rows[2] * Float4::broadcast(row[2])) + (other_rows[3] * Float4::broadcast(row[3]));
+        sum.store(result.rows[i].getData());
+    }
+
+    return result;
+}
+
+// multiplies every vector in 'in' by 'matrix', 'in' and 'out' may be the same array
+void transform(const Matrix4x4f& matrix, const Vector4f* in, Vector4f* out, size_t count);
+
+static_assert(sizeof(Vector4f) == 16 && alignof(Vector4f) == 16, "Vector4f must be a packed, 16-byte aligned vector");
+static_assert(std::is_trivially_copyable_v<Vector4f> && std::is_standard_layout_v<Vector4f>, "Vector4f must be trivially copyable");
+static_assert(std::is_trivially_copyable_v<Matrix4x4f> && std::is_standard_layout_v<Matrix4x4f>, "Matrix4x4f must be trivially copyable");
+
 } // namespace apparition
 
 #endif // APPARITION_MATH_HH
\ No newline at end of file
@@ -18,16 +18,44 @@
 #ifndef APPARITION_RENDERER_HH
 #define APPARITION_RENDERER_HH
 
+#include <algorithm>
+#include <bit>
+#include <bitset>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
 #include <variant>
 #include <vector>
 
 #include "math.hh"
+#include "simd.hh"
+#include "thread_pool.hh"
 
 namespace apparition {
 
+// upper bound on the number of float varyings a vertex can pass to the fragment shader
+constexpr uint32_t MAX_VARYINGS = 16;
+
 struct Vertex {
     Vector4f position;
-    Vector4f color;
+    float varyings[MAX_VARYINGS] = {};
+};
+
+// upper bound on the number of float attributes an instance can pass to the vertex shader
+constexpr uint32_t MAX_INSTANCE_ATTRIBUTES = 16;
+
+// per-instance data of an instanced draw, non-instanced draws run as a single default instance
+struct Instance {
+    Matrix4x4f transform = Matrix4x4f::identity();
+    float attributes[MAX_INSTANCE_ATTRIBUTES] = {};
+};
+
+// describes which leading varyings of every vertex are interpolated, the default
+// layout carries a single rgba color
+struct VertexLayout {
+    uint32_t varying_count = 4;
 };
 
 enum class PrimitiveType {
@@ -40,47 +68,386 @@ struct Primitive {
     PrimitiveType type;
 };
 
+// assembled primitives refer to vertices of the draw's shaded vertex cache by index
 struct Line : Primitive {
-    Line(Vertex _vertex_0, Vertex _vertex_1) : Primitive(PrimitiveType::LINE), vertex_0(_vertex_0), vertex_1(_vertex_1) {}
-    Vertex vertex_0;
-    Vertex vertex_1;
+    Line(uint32_t _vertex_0, uint32_t _vertex_1) : Primitive(PrimitiveType::LINE), vertex_0(_vertex_0), vertex_1(_vertex_1) {}
+    uint32_t vertex_0;
+    uint32_t vertex_1;
 };
 
 struct Tri : Primitive {
-    Tri(Vertex _vertex_0, Vertex _vertex_1, Vertex _vertex_2) : Primitive(PrimitiveType::TRI), vertex_0(_vertex_0), vertex_1(_vertex_1), vertex_2(_vertex_2) {}
-    Vertex vertex_0;
-    Vertex vertex_1;
-    Vertex vertex_2;
+    Tri(uint32_t _vertex_0, uint32_t _vertex_1, uint32_t _vertex_2) : Primitive(PrimitiveType::TRI), vertex_0(_vertex_0), vertex_1(_vertex_1), vertex_2(_vertex_2) {}
+    uint32_t vertex_0;
+    uint32_t vertex_1;
+    uint32_t vertex_2;
+};
+
+// maps normalized device coordinates to frame buffer pixels and depth values,
+// an empty viewport covers the whole bound frame buffer
+struct Viewport {
+    int32_t x = 0;
+    int32_t y = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    float min_depth = 0.0f;
+    float max_depth = 1.0f;
+};
+
+enum class CullMode {
+    NONE,
+    FRONT,
+    BACK
+};
+
+// winding of front-facing tris after the viewport transform
+enum class FrontFace {
+    COUNTER_CLOCKWISE,
+    CLOCKWISE
+};
+
+// smooth lines are drawn with wu coverage and blended over the color buffer in submission
+// order, they are about one pixel wide with fractional endpoints
+enum class LineMode {
+    ALIASED,
+    SMOOTH
+};
+
+// strips reuse the previous one or two indices, fans share the first index across all tris
+enum class LineTopology {
+    LIST,
+    STRIP
+};
+
+enum class TriTopology {
+    LIST,
+    STRIP,
+    FAN
+};
+
+// the bound index buffer, draws without one consume the vertex buffer in order
+using IndexBufferBinding = std::variant<std::monostate, std::vector<uint16_t>*, std::vector<uint32_t>*, std::vector<size_t>*>;
+
+enum class DepthFunction {
+    NEVER,
+    LESS,
+    EQUAL,
+    LESS_EQUAL,
+    GREATER,
+    NOT_EQUAL,
+    GREATER_EQUAL,
+    ALWAYS
+};
+
+template<typename T>
+bool testDepth(DepthFunction function, T depth, T stored_depth) {
+    switch (function) {
+        case DepthFunction::NEVER:
+            return false;
+        case DepthFunction::LESS:
+            return depth < stored_depth;
+        case DepthFunction::EQUAL:
+            return depth == stored_depth;
+        case DepthFunction::LESS_EQUAL:
+            return depth <= stored_depth;
+        case DepthFunction::GREATER:
+            return depth > stored_depth;
+        case DepthFunction::NOT_EQUAL:
+            return depth != stored_depth;
+        case DepthFunction::GREATER_EQUAL:
+            return depth >= stored_depth;
+        case DepthFunction::ALWAYS:
+            return true;
+    }
+
+    return false;
+}
+
+// conservative range of the depths stored in a region of a depth buffer
+struct DepthBounds {
+    float min;
+    float max;
+};
+
+// false if no depth in [min_depth, max_depth] can pass the depth test against any depth in
+// bounds, epsilon covers quantization and interpolation error so rejection stays conservative
+inline bool testDepthBounds(DepthFunction function, float min_depth, float max_depth, DepthBounds bounds, float epsilon) {
+    switch (function) {
+        case DepthFunction::NEVER:
+            return false;
+        case DepthFunction::LESS:
+        case DepthFunction::LESS_EQUAL:
+            return min_depth - epsilon <= bounds.max;
+        case DepthFunction::EQUAL:
+            return min_depth - epsilon <= bounds.max && max_depth + epsilon >= bounds.min;
+        case DepthFunction::GREATER:
+        case DepthFunction::GREATER_EQUAL:
+            return max_depth + epsilon >= bounds.min;
+        case DepthFunction::NOT_EQUAL:
+        case DepthFunction::ALWAYS:
+            return true;
+    }
+
+    return true;
+}
+
+// inputs of a single fragment shader invocation, varyings past the bound layout's count are undefined
+struct FragmentInput {
+    Vector2u position;
+    float depth;
+    float varyings[MAX_VARYINGS];
+};
+
+// inputs of a fragment shader invocation on a 2x2 quad in structure-of-arrays form, lanes are
+// ordered (x, y), (x + 1, y), (x, y + 1), (x + 1, y + 1) from the top-left pixel in position,
+// lanes missing from mask are helpers interpolated from the same primitive
+struct QuadInput {
+    Vector2u position;
+    uint32_t mask;
+    Float4 depth;
+    Float4 varyings[MAX_VARYINGS];
+};
+
+struct QuadOutput {
+    Float4 color[4];
+};
+
+// screen-space derivatives of a quad value, shared by both lanes of each row or column
+inline Float4 ddx(Float4 value) {
+    return shuffle<1, 1, 3, 3>(value) - shuffle<0, 0, 2, 2>(value);
+}
+
+inline Float4 ddy(Float4 value) {
+    return shuffle<2, 3, 2, 3>(value) - shuffle<0, 1, 0, 1>(value);
+}
+
+// number of vertices shaded together by a batch vertex shader, one per Float4 lane
+constexpr uint32_t VERTEX_BATCH_SIZE = 4;
+
+// a batch of vertices in structure-of-arrays form, lane i holds the vertex buffer entry indices[i],
+// lanes missing from mask are padding and their results are discarded
+struct VertexBatch {
+    uint32_t mask;
+    uint32_t indices[VERTEX_BATCH_SIZE];
+    Float4 position[4];
+    Float4 varyings[MAX_VARYINGS];
+};
+
+// multiplies every position of a batch by a matrix
+inline void transformBatch(const Matrix4x4f& matrix, Float4 position[4]) {
+    Float4 result[4];
+    for (size_t r = 0; r < 4; ++r) {
+        result[r] = (Float4::broadcast(matrix[r][0]) * position[0]) + (Float4::broadcast(matrix[r][1]) * position[1]) +
+            (Float4::broadcast(matrix[r][2]) * position[2]) + (Float4::broadcast(matrix[r][3]) * position[3]);
+    }
+
+    for (size_t r = 0; r < 4; ++r) {
+        position[r] = result[r];
+    }
+}
+
+// vertex shaders may take the instance being drawn as a second parameter
+template<typename S>
+concept SingleVertexShader = requires(S shader, Vertex& vertex, const Instance& instance) {
+    shader.vertex(vertex);
+} || requires(S shader, Vertex& vertex, const Instance& instance) {
+    shader.vertex(vertex, instance);
+};
+
+template<typename S>
+concept BatchVertexShader = requires(S shader, VertexBatch& batch) {
+    shader.vertexBatch(batch);
+} || requires(S shader, VertexBatch& batch, const Instance& instance) {
+    shader.vertexBatch(batch, instance);
+};
+
+template<typename S>
+concept PixelFragmentShader = requires(S shader, const FragmentInput& fragment) {
+    { shader.fragment(fragment) } -> std::convertible_to<Vector4f>;
+};
+
+template<typename S>
+concept QuadFragmentShader = requires(S shader, const QuadInput& quad, QuadOutput& output) {
+    shader.fragmentQuad(quad, output);
+};
+
+// shaders passed to the templated draw calls are inlined into the vertex and fragment loops,
+// every render worker shades with its own copy, shaders providing vertexBatch or fragmentQuad
+// are run once per batch of vertices or 2x2 quad instead of once per vertex or pixel
+template<typename S>
+concept ShaderProgram = std::copy_constructible<S> && (SingleVertexShader<S> || BatchVertexShader<S>) && (PixelFragmentShader<S> || QuadFragmentShader<S>);
+
+// distance in pixels past the viewport that tris can reach before they are clipped in x and y,
+// everything inside is left to the scissor so only the near plane clips ordinary geometry
+constexpr float GUARD_BAND = 16384.0f;
+
+// the viewport of a draw resolved against the bound frame buffer, screen = ndc * scale + offset,
+// guard is the guard band half extent in clip space units of w and the scissor rectangle is
+// the intersection of viewport and frame buffer, empty if min exceeds max
+struct ViewportTransform {
+    float scale_x;
+    float scale_y;
+    float scale_z;
+    float offset_x;
+    float offset_y;
+    float offset_z;
+    float guard_x;
+    float guard_y;
+    uint32_t min_x;
+    uint32_t min_y;
+    uint32_t max_x;
+    uint32_t max_y;
+};
+
+// number of fractional bits used for snapped screen-space vertex positions
+constexpr int32_t SUBPIXEL_BITS = 8;
+constexpr int64_t SUBPIXEL_ONE = int64_t(1) << SUBPIXEL_BITS;
+
+// edge function e(x, y) = a * x + b * y + c, evaluated at pixel (x, y) it gives the value at the
+// pixel center, pixels with e >= 0 on all edges are covered and edges that are not top or left
+// edges are biased by one so pixel centers exactly on them belong to the neighbouring tri
+struct EdgeFunction {
+    int64_t a;
+    int64_t b;
+    int64_t c;
+};
+
+// screen-space attribute f(x, y) = a * (x - origin_x) + b * (y - origin_y) + c, like edge
+// functions it gives the value at the center of pixel (x, y)
+struct AttributePlane {
+    float a;
+    float b;
+    float c;
+};
+
+// attribute planes of a primitive computed once in setup, varyings and 1 / w are planes of
+// v / w so dividing by the interpolated 1 / w gives perspective-correct values, depth is linear
+struct AttributeSetup {
+    int32_t origin_x;
+    int32_t origin_y;
+    uint32_t varying_count;
+    AttributePlane depth;
+    AttributePlane inverse_w;
+    AttributePlane varyings[MAX_VARYINGS];
 };
 
-struct Fragment {
-    float depth = std::numeric_limits<float>::min();
-    float t;
-    float b0;
-    float b1;
-    float b2;
-    Primitive* primitive = nullptr;
+// min_depth and max_depth bound the vertex depths for hierarchical depth rejection
+struct TriSetup {
+    EdgeFunction edges[3];
+    AttributeSetup attributes;
+    float min_depth;
+    float max_depth;
+    uint32_t min_x;
+    uint32_t min_y;
+    uint32_t max_x;
+    uint32_t max_y;
 };
 
+// x0, y0, x1 and y1 are the rounded endpoints walked by aliased lines, start and end keep the
+// unrounded positions smooth lines are drawn between, both with pixel centers on integers
+struct LineSetup {
+    AttributeSetup attributes;
+    float min_depth;
+    float max_depth;
+    float start_x;
+    float start_y;
+    float end_x;
+    float end_y;
+    int32_t x0;
+    int32_t y0;
+    int32_t x1;
+    int32_t y1;
+    uint32_t min_x;
+    uint32_t min_y;
+    uint32_t max_x;
+    uint32_t max_y;
+};
+
+// number of vertex buffer entries a vertex shading task covers
+constexpr size_t VERTEX_BLOCK_SIZE = 1024;
+
+// side length in pixels of the square screen tiles primitives are binned into
+constexpr uint32_t TILE_SIZE = 64;
+
+constexpr uint32_t TILE_QUADS = (TILE_SIZE / 2) * (TILE_SIZE / 2);
+
+// a screen region owned by exactly one worker while a draw is rasterized and shaded,
+// covered lists the 2x2 quads of the tile the draw wrote a fragment to
+struct Tile {
+    uint32_t min_x;
+    uint32_t min_y;
+    uint32_t max_x;
+    uint32_t max_y;
+    std::vector<size_t> primitives;
+    std::vector<uint16_t> covered;
+    std::bitset<TILE_QUADS> covered_quads;
+    void cover(uint32_t x, uint32_t y);
+};
+
+inline void Tile::cover(uint32_t x, uint32_t y) {
+    uint16_t quad = (((y - this->min_y) / 2) * (TILE_SIZE / 2)) + ((x - this->min_x) / 2);
+    if (!this->covered_quads[quad]) {
+        this->covered_quads[quad] = true;
+        this->covered.push_back(quad);
+    }
+}
+
+// how a 2d buffer orders its pixels in memory, tiled buffers store square blocks of
+// BUFFER_BLOCK_SIZE pixels contiguously so a screen tile touches few cache lines
+enum class BufferLayout {
+    LINEAR,
+    TILED
+};
+
+constexpr uint32_t BUFFER_BLOCK_SIZE = 8;
+
+// every pixel occupies stride consecutive elements, indices returned by getIndex count pixels,
+// fillDeferred only flags every block of BUFFER_BLOCK_SIZE pixels as cleared and a block is
+// written with the clear value once resolve covers it, index based access expects the block
+// resolved while get, set, getData and copyToLinear resolve on their own, getRawData returns
+// the storage without resolving so several threads can read a buffer known to be resolved
 template<typename T>
 class BaseBuffer2D {
     public:
-        BaseBuffer2D(Vector2u dimensions);
+        BaseBuffer2D(Vector2u dimensions, BufferLayout layout = BufferLayout::LINEAR, uint32_t stride = 1);
         ~BaseBuffer2D();
         Vector2u getDimensions();
+        BufferLayout getLayout();
+        uint32_t getStride();
         T* getData();
+        T* getRawData();
+        size_t getIndex(Vector2u position);
+        size_t getQuadPitch();
         T& get(Vector2u position);
         void set(Vector2u position, T value);
+        void fill(T value);
+        void fillDeferred(const T* value);
+        void resolve(uint32_t min_x, uint32_t min_y, uint32_t max_x, uint32_t max_y);
+        void copyToLinear(T* destination);
     protected:
-        size_t getIndex(Vector2u position);
+        size_t getSize();
+        void resolveBlock(uint32_t block_x, uint32_t block_y);
         Vector2u dimensions;
+        BufferLayout layout;
+        uint32_t stride;
+        uint32_t block_columns;
+        uint32_t block_rows;
         T* data;
+        std::vector<T> clear_value;
+        std::vector<uint8_t> pending;
+        bool any_pending;
 };
 
 template<typename T>
-BaseBuffer2D<T>::BaseBuffer2D(Vector2u dimensions) {
+BaseBuffer2D<T>::BaseBuffer2D(Vector2u dimensions, BufferLayout layout, uint32_t stride) {
     this->dimensions = dimensions;
-    this->data = new T[dimensions.x * dimensions.y];
+    this->layout = layout;
+    this->stride = stride;
+    this->block_columns = (dimensions.x + BUFFER_BLOCK_SIZE - 1) / BUFFER_BLOCK_SIZE;
+    this->block_rows = (dimensions.y + BUFFER_BLOCK_SIZE - 1) / BUFFER_BLOCK_SIZE;
+    this->data = new T[this->getSize() * stride];
+    this->clear_value.resize(stride);
+    this->pending.resize(static_cast<size_t>(this->block_columns) * this->block_rows);
+    this->any_pending = false;
 }
 
 template<typename T>
@@ -93,77 +460,741 @@ Vector2u BaseBuffer2D<T>::getDimensions() {
     return this->dimensions;
 }
 
+template<typename T>
+BufferLayout BaseBuffer2D<T>::getLayout() {
+    return this->layout;
+}
+
+template<typename T>
+uint32_t BaseBuffer2D<T>::getStride() {
+    return this->stride;
+}
+
+// pixels are stored in the layout of the buffer, use getIndex to address them
+// or copyToLinear to read them back in row-major order
 template<typename T>
 T* BaseBuffer2D<T>::getData() {
+    if (this->any_pending) {
+        for (uint32_t block_y = 0; block_y < this->block_rows; ++block_y) {
+            for (uint32_t block_x = 0; block_x < this->block_columns; ++block_x) {
+                if (this->pending[(static_cast<size_t>(block_y) * this->block_columns) + block_x]) {
+                    this->resolveBlock(block_x, block_y);
+                }
+            }
+        }
+        this->any_pending = false;
+    }
+
     return this->data;
 }
 
+template<typename T>
+T* BaseBuffer2D<T>::getRawData() {
+    return this->data;
+}
+
+template<typename T>
+size_t BaseBuffer2D<T>::getIndex(Vector2u position) {
+    if (this->layout == BufferLayout::LINEAR) {
+        return (static_cast<size_t>(position.y) * this->dimensions.x) + position.x;
+    }
+
+    size_t block = (static_cast<size_t>(position.y / BUFFER_BLOCK_SIZE) * this->block_columns) + (position.x / BUFFER_BLOCK_SIZE);
+    return (block * BUFFER_BLOCK_SIZE * BUFFER_BLOCK_SIZE) + ((position.y % BUFFER_BLOCK_SIZE) * BUFFER_BLOCK_SIZE) + (position.x % BUFFER_BLOCK_SIZE);
+}
+
+// distance between the two rows of a 2x2 quad starting on even coordinates,
+// quads never straddle a block so the rows of a quad are a block row apart in tiled buffers
+template<typename T>
+size_t BaseBuffer2D<T>::getQuadPitch() {
+    return this->layout == BufferLayout::LINEAR ? this->dimensions.x : BUFFER_BLOCK_SIZE;
+}
+
 template<typename T>
 T& BaseBuffer2D<T>::get(Vector2u position) {
-    if (position.x < 0 || position.x >= this->dimensions.x || position.y < 0 || position.y >= this->dimensions.y) {
+    if (position.x >= this->dimensions.x || position.y >= this->dimensions.y) {
         throw std::out_of_range("'position' is out of range");
     }
 
-    return this->data[this->getIndex(position)];
+    this->resolve(position.x, position.y, position.x, position.y);
+    return this->data[this->getIndex(position) * this->stride];
 }
 
 template<typename T>
 void BaseBuffer2D<T>::set(Vector2u position, T value) {
-    if (position.x < 0 || position.x >= this->dimensions.x || position.y < 0 || position.y >= this->dimensions.y) {
+    if (position.x >= this->dimensions.x || position.y >= this->dimensions.y) {
         throw std::out_of_range("'position' is out of range");
     }
 
-    this->data[this->getIndex(position)] = value;
+    this->resolve(position.x, position.y, position.x, position.y);
+    this->data[this->getIndex(position) * this->stride] = value;
 }
 
 template<typename T>
-size_t BaseBuffer2D<T>::getIndex(Vector2u position) {
-    return (position.y * this->dimensions.x) + position.x;
+void BaseBuffer2D<T>::fill(T value) {
+    std::fill(this->data, this->data + (this->getSize() * this->stride), value);
+    std::fill(this->pending.begin(), this->pending.end(), 0);
+    this->any_pending = false;
+}
+
+// value holds the stride elements of one pixel, the cost is one flag per block
+template<typename T>
+void BaseBuffer2D<T>::fillDeferred(const T* value) {
+    std::copy(value, value + this->stride, this->clear_value.begin());
+    std::fill(this->pending.begin(), this->pending.end(), 1);
+    this->any_pending = true;
+}
+
+// writes the clear value to every pending block in the rectangle, blocks of different render
+// tiles can be resolved from different threads
+template<typename T>
+void BaseBuffer2D<T>::resolve(uint32_t min_x, uint32_t min_y, uint32_t max_x, uint32_t max_y) {
+    if (!this->any_pending) {
+        return;
+    }
+
+    for (uint32_t block_y = min_y / BUFFER_BLOCK_SIZE; block_y <= max_y / BUFFER_BLOCK_SIZE; ++block_y) {
+        for (uint32_t block_x = min_x / BUFFER_BLOCK_SIZE; block_x <= max_x / BUFFER_BLOCK_SIZE; ++block_x) {
+            if (this->pending[(static_cast<size_t>(block_y) * this->block_columns) + block_x]) {
+                this->resolveBlock(block_x, block_y);
+            }
+        }
+    }
 }
 
-class ColorBuffer : public BaseBuffer2D<Vector4f> {
+// destination has to hold width * height * stride elements
+template<typename T>
+void BaseBuffer2D<T>::copyToLinear(T* destination) {
+    if (!destination) {
+        throw std::invalid_argument("'destination' cannot be nullptr");
+    }
+
+    this->getData();
+    if (this->layout == BufferLayout::LINEAR) {
+        std::copy(this->data, this->data + (this->getSize() * this->stride), destination);
+        return;
+    }
+
+    // copy a block row at a time so every block is read front to back
+    for (uint32_t y = 0; y < this->dimensions.y; ++y) {
+        T* row = destination + (static_cast<size_t>(y) * this->dimensions.x * this->stride);
+        for (uint32_t x = 0; x < this->dimensions.x; x += BUFFER_BLOCK_SIZE) {
+            const T* source = this->data + (this->getIndex(Vector2u(x, y)) * this->stride);
+            std::copy(source, source + (std::min(BUFFER_BLOCK_SIZE, this->dimensions.x - x) * this->stride), row + (x * this->stride));
+        }
+    }
+}
+
+// tiled buffers are padded to whole blocks
+template<typename T>
+size_t BaseBuffer2D<T>::getSize() {
+    if (this->layout == BufferLayout::LINEAR) {
+        return static_cast<size_t>(this->dimensions.x) * this->dimensions.y;
+    }
+
+    return static_cast<size_t>(this->block_columns) * this->block_rows * BUFFER_BLOCK_SIZE * BUFFER_BLOCK_SIZE;
+}
+
+// both layouts keep the pixels of a block row next to each other
+template<typename T>
+void BaseBuffer2D<T>::resolveBlock(uint32_t block_x, uint32_t block_y) {
+    uint32_t min_x = block_x * BUFFER_BLOCK_SIZE;
+    uint32_t min_y = block_y * BUFFER_BLOCK_SIZE;
+    uint32_t width = std::min(BUFFER_BLOCK_SIZE, this->dimensions.x - min_x);
+    uint32_t height = std::min(BUFFER_BLOCK_SIZE, this->dimensions.y - min_y);
+    for (uint32_t y = min_y; y < min_y + height; ++y) {
+        T* row = this->data + (this->getIndex(Vector2u(min_x, y)) * this->stride);
+        for (uint32_t x = 0; x < width; ++x) {
+            std::copy(this->clear_value.begin(), this->clear_value.end(), row + (x * this->stride));
+        }
+    }
+
+    this->pending[(static_cast<size_t>(block_y) * this->block_columns) + block_x] = 0;
+}
+
+// storage formats of color buffers, colors are converted when written and unorm formats
+// clamp every channel to [0, 1]
+enum class ColorFormat {
+    RGBA32F,
+    RGBA16F,
+    RGB10A2_UNORM,
+    RGBA8_UNORM
+};
+
+// storage formats of depth buffers, unorm formats clamp depth to [0, 1] and test the
+// quantized value, the stencil bits of D24S8 are cleared to zero and otherwise left alone
+enum class DepthFormat {
+    D32F,
+    D24S8,
+    D16
+};
+
+uint32_t getColorFormatSize(ColorFormat format);
+uint32_t getDepthFormatSize(DepthFormat format);
+
+constexpr uint32_t MAX_SAMPLES = 8;
+
+// offset of a sample from its pixel center in sixteenths of a pixel
+struct SamplePosition {
+    int32_t x;
+    int32_t y;
+};
+
+// the standard 1x, 2x, 4x and 8x sample patterns, throws for any other sample count
+const SamplePosition* getSamplePositions(uint32_t sample_count);
+
+// get, set, fill and clear convert between the stored format and floats, fill writes every
+// pixel right away while clear defers the writes like DepthBuffer::clear, getData returns
+// the packed bytes, new buffers start out cleared to zero, multisampled buffers store the
+// samples of a pixel next to each other, reads average them and writes set all of them
+class ColorBuffer : public BaseBuffer2D<uint8_t> {
     public:
-        ColorBuffer(Vector2u dimensions) : BaseBuffer2D(dimensions) {}
+        ColorBuffer(Vector2u dimensions, BufferLayout layout = BufferLayout::LINEAR, ColorFormat format = ColorFormat::RGBA32F, uint32_t sample_count = 1);
+        ColorFormat getFormat();
+        uint32_t getSampleCount();
+        Vector4f get(Vector2u position);
+        void set(Vector2u position, Vector4f color);
+        void fill(Vector4f color);
+        void clear(Vector4f color);
+        void copyToLinear(Vector4f* destination);
+        void copyFromLinear(const Vector4f* source);
+        void resolveSamples(ColorBuffer* destination);
+        Vector4f load(size_t index);
+        void store(size_t index, Vector4f color);
+        void storeQuad(const uint32_t indices[4], const uint32_t sample_masks[4], const Vector4f colors[4]);
+        void blendQuad(const uint32_t indices[4], const uint32_t sample_masks[4], const Vector4f colors[4], const float coverage[4]);
+    private:
+        ColorFormat format;
+        uint32_t sample_count;
 };
 
-class DepthBuffer : public BaseBuffer2D<Fragment> {
+// new buffers start out cleared to the far plane, the buffer keeps the min and max depth of
+// every block of BUFFER_BLOCK_SIZE pixels as a hierarchical depth level, blocks are refreshed
+// lazily when their bounds are asked for after a write, writes through test or getData leave
+// the bounds stale until invalidateBounds covers them or expandBounds widens them, get reads
+// the first sample of a multisampled buffer and set writes all of them
+class DepthBuffer : public BaseBuffer2D<uint8_t> {
     public:
-        DepthBuffer(Vector2u dimensions) : BaseBuffer2D(dimensions) {}
+        DepthBuffer(Vector2u dimensions, BufferLayout layout = BufferLayout::LINEAR, DepthFormat format = DepthFormat::D32F, uint32_t sample_count = 1);
+        DepthFormat getFormat();
+        uint32_t getSampleCount();
+        float get(Vector2u position);
+        void set(Vector2u position, float depth);
+        void clear(float depth);
+        bool test(size_t index, uint32_t sample, DepthFunction function, float depth, bool write);
+        DepthBounds getBounds(uint32_t min_x, uint32_t min_y, uint32_t max_x, uint32_t max_y);
+        void invalidateBounds(uint32_t min_x, uint32_t min_y, uint32_t max_x, uint32_t max_y);
+        void expandBounds(uint32_t min_x, uint32_t min_y, uint32_t max_x, uint32_t max_y, DepthBounds depths);
+        float getBoundsEpsilon();
+    private:
+        float load(size_t index, uint32_t sample);
+        DepthFormat format;
+        uint32_t sample_count;
+        std::vector<DepthBounds> bounds;
+        std::vector<uint8_t> stale;
 };
 
+// 1-based index of the render pass primitive covering each sample, zero outside of a pass
+class PrimitiveBuffer : public BaseBuffer2D<uint32_t> {
+    public:
+        PrimitiveBuffer(Vector2u dimensions, BufferLayout layout = BufferLayout::LINEAR, uint32_t sample_count = 1) : BaseBuffer2D(dimensions, layout, sample_count) {}
+};
+
+// multisampled frame buffers cover and depth test every sample on its own but shade once per
+// pixel and primitive, resolve their color buffer with ColorBuffer::resolveSamples
 class FrameBuffer {
     public:
-        FrameBuffer(Vector2u dimensions);
+        FrameBuffer(Vector2u dimensions, BufferLayout layout = BufferLayout::LINEAR, ColorFormat color_format = ColorFormat::RGBA32F, DepthFormat depth_format = DepthFormat::D32F, uint32_t sample_count = 1);
         ~FrameBuffer();
         Vector2u getDimensions();
+        uint32_t getSampleCount();
         ColorBuffer* getColorBuffer();
         DepthBuffer* getDepthBuffer();
+        PrimitiveBuffer* getPrimitiveBuffer();
+        void clear(Vector4f color, float depth = 1.0f);
     private:
         Vector2u dimensions;
+        uint32_t sample_count;
         ColorBuffer* color_buffer;
         DepthBuffer* depth_buffer;
+        PrimitiveBuffer* primitive_buffer;
+};
+
+// nearest and bilinear read the mip level closest to the level of detail of a lookup,
+// trilinear blends the bilinear results of the two levels around it
+enum class TextureFilter {
+    NEAREST,
+    BILINEAR,
+    TRILINEAR
+};
+
+// how texture coordinates outside of [0, 1] are mapped onto the texture
+enum class TextureWrap {
+    REPEAT,
+    CLAMP
+};
+
+// lod_bias is added to the level of detail of every lookup
+struct Sampler {
+    TextureFilter filter = TextureFilter::TRILINEAR;
+    TextureWrap wrap = TextureWrap::REPEAT;
+    float lod_bias = 0.0f;
 };
 
+// number of levels in a full mip chain down to 1x1
+uint32_t getMipLevelCount(Vector2u dimensions);
+
+// a 2d texture with a chain of mip levels, each level is a tiled color buffer so the texels of a
+// lookup share a block and a few cache lines, levels are written through getLevel and
+// generateMips filters every level from the first one, fragment shaders sample from all render
+// workers at once so the levels have to be written before the draws reading them are flushed,
+// lookups read the levels as stored so a deferred clear of a level has to be resolved with
+// getData on the calling thread first
+class Texture2D {
+    public:
+        Texture2D(Vector2u dimensions, ColorFormat format = ColorFormat::RGBA8_UNORM, uint32_t level_count = 1);
+        ~Texture2D();
+        Vector2u getDimensions();
+        ColorFormat getFormat();
+        uint32_t getLevelCount();
+        ColorBuffer* getLevel(uint32_t level);
+        void generateMips();
+        Vector4f sample(const Sampler& sampler, Vector2f coordinates, float lod = 0.0f);
+        void sampleQuad(const Sampler& sampler, Float4 u, Float4 v, Float4 color[4]);
+    private:
+        Vector2u dimensions;
+        ColorFormat format;
+        std::vector<ColorBuffer*> levels;
+};
+
+// fragment stage of a draw queued into a render pass, erased from the shader type so draws
+// with different shaders can be rasterized and shaded together, shadeQuad writes the colors
+// of the lanes in the mask and the renderer stores them to the samples they cover
+class PassProgram {
+    public:
+        virtual ~PassProgram() = default;
+        virtual size_t getWorkerCount() = 0;
+        virtual void shadeQuad(size_t worker, const QuadInput& input, const AttributeSetup& attributes, Vector4f colors[4]) = 0;
+};
+
+template<ShaderProgram S>
+class ShaderPassProgram : public PassProgram {
+    public:
+        ShaderPassProgram(std::vector<S>&& worker_shaders) : worker_shaders(std::move(worker_shaders)) {}
+        std::vector<S>& getWorkerShaders();
+        size_t getWorkerCount() override;
+        void shadeQuad(size_t worker, const QuadInput& input, const AttributeSetup& attributes, Vector4f colors[4]) override;
+    private:
+        std::vector<S> worker_shaders;
+};
+
+// a draw of the current render pass with the state it was queued with
+struct PassDraw {
+    DepthFunction depth_function;
+    bool depth_write;
+    LineMode line_mode;
+    std::unique_ptr<PassProgram> program;
+};
+
+// primitives of a pass in submission order, setup indexes the pass's line or tri setups
+struct PassPrimitive {
+    PrimitiveType type;
+    uint32_t draw;
+    uint32_t setup;
+};
+
+// draws queued for the bound frame buffer that are binned, rasterized and shaded together
+struct RenderPass {
+    std::vector<PassDraw> draws;
+    std::vector<PassPrimitive> primitives;
+    std::vector<LineSetup> line_setups;
+    std::vector<TriSetup> tri_setups;
+};
+
+// the bindings and draw state Renderer::submit starts every command buffer from
+struct RenderState {
+    FrameBuffer* frame_buffer;
+    std::vector<Vertex>* vertex_buffer;
+    IndexBufferBinding index_buffer;
+    DepthFunction depth_function;
+    bool depth_write;
+    VertexLayout vertex_layout;
+    Viewport viewport;
+    CullMode cull_mode;
+    FrontFace front_face;
+    LineMode line_mode;
+};
+
+class CommandBuffer;
 class Shader;
 
 class Renderer {
     public:
         Renderer();
+        ~Renderer();
+        void setThreadCount(size_t thread_count);
+        size_t getThreadCount();
+        void setDepthFunction(DepthFunction depth_function);
+        DepthFunction getDepthFunction();
+        void setDepthWrite(bool depth_write);
+        bool getDepthWrite();
+        void setVertexLayout(VertexLayout vertex_layout);
+        VertexLayout getVertexLayout();
+        void setViewport(Viewport viewport);
+        Viewport getViewport();
+        void setCullMode(CullMode cull_mode);
+        CullMode getCullMode();
+        void setFrontFace(FrontFace front_face);
+        FrontFace getFrontFace();
+        void setLineMode(LineMode line_mode);
+        LineMode getLineMode();
         void bindFrameBuffer(FrameBuffer* to_bind);
         void bindVertexBuffer(std::vector<Vertex>* to_bind);
+        void bindIndexBuffer(std::vector<uint16_t>* to_bind);
+        void bindIndexBuffer(std::vector<uint32_t>* to_bind);
         void bindIndexBuffer(std::vector<size_t>* to_bind);
+        void unbindIndexBuffer();
         void bindShader(Shader* to_bind);
-        void drawLines();
-        void drawTris();
+        void clear(Vector4f color, float depth = 1.0f);
+        void resolve(ColorBuffer* destination);
+        void drawLines(LineTopology topology = LineTopology::LIST);
+        void drawTris(TriTopology topology = TriTopology::LIST);
+        template<ShaderProgram S> void drawLines(S& shader, LineTopology topology = LineTopology::LIST);
+        template<ShaderProgram S> void drawTris(S& shader, TriTopology topology = TriTopology::LIST);
+        template<ShaderProgram S> void drawLinesInstanced(S& shader, size_t instance_count, std::vector<Instance>* instance_buffer, LineTopology topology = LineTopology::LIST);
+        template<ShaderProgram S> void drawTrisInstanced(S& shader, size_t instance_count, std::vector<Instance>* instance_buffer, TriTopology topology = TriTopology::LIST);
+        void submit(const std::vector<CommandBuffer*>& command_buffers);
     private:
+        friend class CommandBuffer;
         FrameBuffer* frame_buffer;
         std::vector<Vertex>* vertex_buffer;
-        std::vector<size_t>* index_buffer;
+        IndexBufferBinding index_buffer;
         Shader* shader;
-        void runVertexShader(Vertex& in_vertex);
-        void runFragmentShader(Vector2u in_fragment_position, Fragment in_fragment);
+        DepthFunction depth_function;
+        bool depth_write;
+        VertexLayout vertex_layout;
+        Viewport viewport;
+        CullMode cull_mode;
+        FrontFace front_face;
+        LineMode line_mode;
+        ThreadPool* thread_pool;
+        std::vector<Vertex> shaded_vertices;
+        std::vector<uint32_t> shaded_draws;
+        uint32_t draw_id;
+        RenderPass pass;
+        std::vector<Tile> tiles;
+        Vector2u tiles_dimensions;
+        std::vector<float> line_coverage;
+        std::vector<uint8_t> line_samples;
+        void checkDrawState();
+        RenderState saveState();
+        void restoreState(const RenderState& state);
+        void checkInstances(size_t instance_count, std::vector<Instance>* instance_buffer);
+        void markVertices();
+        std::vector<Line> assembleLines(LineTopology topology);
+        std::vector<Tri> assembleTris(TriTopology topology);
+        void prepareVertexCache();
+        template<ShaderProgram S> void shadeVertices(std::vector<S>& worker_shaders, const Instance& instance);
+        template<ShaderProgram S> void shadeVertexBlock(S& vertex_shader, size_t block, const Instance& instance);
+        template<ShaderProgram S> void queueLines(S& shader, LineTopology topology, const Instance* instances, size_t instance_count);
+        template<ShaderProgram S> void queueTris(S& shader, TriTopology topology, const Instance* instances, size_t instance_count);
+        template<ShaderProgram S> void queueLines(std::vector<S>&& worker_shaders, LineTopology topology, const Instance* instances, size_t instance_count);
+        template<ShaderProgram S> void queueTris(std::vector<S>&& worker_shaders, TriTopology topology, const Instance* instances, size_t instance_count);
+        uint32_t beginPassDraw(std::unique_ptr<PassProgram> program);
+        void discardPass();
+        void discardTiles();
+        void clipLines(const std::vector<Line>& lines, const ViewportTransform& transform, uint32_t draw);
+        void clipTris(const std::vector<Tri>& tris, const ViewportTransform& transform, uint32_t draw);
+        void flushPass();
+        ViewportTransform resolveViewport();
+        void prepareTiles(Vector2u dimensions);
+        void binPrimitive(size_t index, uint32_t min_x, uint32_t min_y, uint32_t max_x, uint32_t max_y);
+        void renderTile(Tile& tile, size_t worker);
+        void shadeTile(Tile& tile, size_t worker);
+        void clipLine(const Line& line, const ViewportTransform& transform, LineMode line_mode, std::vector<LineSetup>& setups);
+        std::optional<LineSetup> setupLine(const Vertex& vertex_0, const Vertex& vertex_1, const ViewportTransform& transform, LineMode line_mode);
+        bool rasterizeLine(LineSetup& setup, uint32_t primitive, const PassDraw& draw, Tile& tile);
+        bool rasterizeSmoothLine(LineSetup& setup, const PassDraw& draw, Tile& tile, size_t worker);
+        void clipTri(const Tri& tri, const ViewportTransform& transform, std::vector<TriSetup>& setups);
+        std::optional<TriSetup> setupTri(const Vertex& vertex_0, const Vertex& vertex_1, const Vertex& vertex_2, const ViewportTransform& transform);
+        bool rasterizeTri(TriSetup& setup, uint32_t primitive, const PassDraw& draw, Tile& tile);
 };
 
+template<ShaderProgram S>
+void Renderer::drawLines(S& shader, LineTopology topology) {
+    Instance instance;
+    this->queueLines(shader, topology, &instance, 1);
+    this->flushPass();
+}
+
+template<ShaderProgram S>
+void Renderer::drawTris(S& shader, TriTopology topology) {
+    Instance instance;
+    this->queueTris(shader, topology, &instance, 1);
+    this->flushPass();
+}
+
+// draws the first instance_count entries of instance_buffer in a single pass, primitives
+// of earlier instances are drawn before those of later ones
+template<ShaderProgram S>
+void Renderer::drawLinesInstanced(S& shader, size_t instance_count, std::vector<Instance>* instance_buffer, LineTopology topology) {
+    this->checkInstances(instance_count, instance_buffer);
+    this->queueLines(shader, topology, instance_buffer->data(), instance_count);
+    this->flushPass();
+}
+
+template<ShaderProgram S>
+void Renderer::drawTrisInstanced(S& shader, size_t instance_count, std::vector<Instance>* instance_buffer, TriTopology topology) {
+    this->checkInstances(instance_count, instance_buffer);
+    this->queueTris(shader, topology, instance_buffer->data(), instance_count);
+    this->flushPass();
+}
+
+template<typename S>
+void runVertexShader(S& shader, Vertex& vertex, const Instance& instance) {
+    if constexpr (requires { shader.vertex(vertex, instance); }) {
+        shader.vertex(vertex, instance);
+    } else {
+        shader.vertex(vertex);
+    }
+}
+
+template<typename S>
+void runVertexShader(S& shader, VertexBatch& batch, const Instance& instance) {
+    if constexpr (requires { shader.vertexBatch(batch, instance); }) {
+        shader.vertexBatch(batch, instance);
+    } else {
+        shader.vertexBatch(batch);
+    }
+}
+
+// shades every vertex marked for the draw once for the given instance, blocks of the vertex
+// buffer are spread over the workers
+template<ShaderProgram S>
+void Renderer::shadeVertices(std::vector<S>& worker_shaders, const Instance& instance) {
+    size_t vertex_count = this->vertex_buffer->size();
+    size_t block_count = (vertex_count + VERTEX_BLOCK_SIZE - 1) / VERTEX_BLOCK_SIZE;
+    auto shade_block = [this, &worker_shaders, &instance](size_t block, size_t worker) {
+        this->shadeVertexBlock(worker_shaders[worker], block, instance);
+    };
+
+    // a single block is not worth waking the pool for, which matters for instanced small meshes
+    if (block_count <= 1 || worker_shaders.size() < this->thread_pool->getThreadCount()) {
+        for (size_t i = 0; i < block_count; ++i) {
+            shade_block(i, 0);
+        }
+    } else {
+        this->thread_pool->run(block_count, shade_block);
+    }
+}
+
+template<ShaderProgram S>
+void Renderer::shadeVertexBlock(S& vertex_shader, size_t block, const Instance& instance) {
+    size_t begin = block * VERTEX_BLOCK_SIZE;
+    size_t end = std::min(begin + VERTEX_BLOCK_SIZE, this->vertex_buffer->size());
+    const Vertex* vertices = this->vertex_buffer->data();
+    Vertex* shaded = this->shaded_vertices.data();
+
+    if constexpr (BatchVertexShader<S>) {
+        uint32_t varying_groups = (this->vertex_layout.varying_count + 3) / 4;
+
+        // referenced vertices are packed into full batches, padding lanes repeat the first one
+        VertexBatch batch;
+        uint32_t count = 0;
+        auto flush = [&]() {
+            batch.mask = (1u << count) - 1;
+            for (uint32_t lane = count; lane < VERTEX_BATCH_SIZE; ++lane) {
+                batch.indices[lane] = batch.indices[0];
+            }
+
+            Float4 lanes[4];
+            for (uint32_t lane = 0; lane < VERTEX_BATCH_SIZE; ++lane) {
+                lanes[lane] = Float4::load(shaded[batch.indices[lane]].position.data);
+            }
+            transpose4x4(lanes[0], lanes[1], lanes[2], lanes[3]);
+            std::copy(lanes, lanes + 4, batch.position);
+
+            for (uint32_t group = 0; group < varying_groups; ++group) {
+                for (uint32_t lane = 0; lane < VERTEX_BATCH_SIZE; ++lane) {
+                    lanes[lane] = Float4::load(shaded[batch.indices[lane]].varyings + (group * 4));
+                }
+                transpose4x4(lanes[0], lanes[1], lanes[2], lanes[3]);
+                std::copy(lanes, lanes + 4, batch.varyings + (group * 4));
+            }
+
+            runVertexShader(vertex_shader, batch, instance);
+
+            std::copy(batch.position, batch.position + 4, lanes);
+            transpose4x4(lanes[0], lanes[1], lanes[2], lanes[3]);
+            for (uint32_t lane = 0; lane < count; ++lane) {
+                lanes[lane].store(shaded[batch.indices[lane]].position.data);
+            }
+
+            for (uint32_t group = 0; group < varying_groups; ++group) {
+                std::copy(batch.varyings + (group * 4), batch.varyings + (group * 4) + 4, lanes);
+                transpose4x4(lanes[0], lanes[1], lanes[2], lanes[3]);
+                for (uint32_t lane = 0; lane < count; ++lane) {
+                    lanes[lane].store(shaded[batch.indices[lane]].varyings + (group * 4));
+                }
+            }
+
+            count = 0;
+        };
+
+        for (size_t i = begin; i < end; ++i) {
+            if (this->shaded_draws[i] != this->draw_id) {
+                continue;
+            }
+
+            shaded[i] = vertices[i];
+            batch.indices[count++] = static_cast<uint32_t>(i);
+            if (count == VERTEX_BATCH_SIZE) {
+                flush();
+            }
+        }
+
+        if (count) {
+            flush();
+        }
+    } else {
+        for (size_t i = begin; i < end; ++i) {
+            if (this->shaded_draws[i] == this->draw_id) {
+                shaded[i] = vertices[i];
+                runVertexShader(vertex_shader, shaded[i], instance);
+            }
+        }
+    }
+}
+
+template<ShaderProgram S>
+void Renderer::queueLines(S& shader, LineTopology topology, const Instance* instances, size_t instance_count) {
+    this->queueLines(std::vector<S>(this->thread_pool->getThreadCount(), shader), topology, instances, instance_count);
+}
+
+template<ShaderProgram S>
+void Renderer::queueTris(S& shader, TriTopology topology, const Instance* instances, size_t instance_count) {
+    this->queueTris(std::vector<S>(this->thread_pool->getThreadCount(), shader), topology, instances, instance_count);
+}
+
+// runs the vertex stage and setup of a draw and adds its primitives to the current pass
+template<ShaderProgram S>
+void Renderer::queueLines(std::vector<S>&& worker_shaders, LineTopology topology, const Instance* instances, size_t instance_count) {
+    this->checkDrawState();
+
+    std::vector<Line> lines = this->assembleLines(topology);
+    this->markVertices();
+
+    // a failed draw takes the rest of the pass with it rather than leaving it half queued
+    try {
+        auto program = std::make_unique<ShaderPassProgram<S>>(std::move(worker_shaders));
+        std::vector<S>& shaders = program->getWorkerShaders();
+        uint32_t draw = this->beginPassDraw(std::move(program));
+
+        // instances share one vertex cache, their lines are set up before the next instance is shaded
+        ViewportTransform transform = this->resolveViewport();
+        for (size_t i = 0; i < instance_count; ++i) {
+            this->shadeVertices(shaders, instances[i]);
+            this->clipLines(lines, transform, draw);
+        }
+    } catch (...) {
+        this->discardPass();
+        throw;
+    }
+}
+
+template<ShaderProgram S>
+void Renderer::queueTris(std::vector<S>&& worker_shaders, TriTopology topology, const Instance* instances, size_t instance_count) {
+    this->checkDrawState();
+
+    std::vector<Tri> tris = this->assembleTris(topology);
+    this->markVertices();
+
+    // a failed draw takes the rest of the pass with it rather than leaving it half queued
+    try {
+        auto program = std::make_unique<ShaderPassProgram<S>>(std::move(worker_shaders));
+        std::vector<S>& shaders = program->getWorkerShaders();
+        uint32_t draw = this->beginPassDraw(std::move(program));
+
+        // instances share one vertex cache, their tris are set up before the next instance is shaded
+        ViewportTransform transform = this->resolveViewport();
+        for (size_t i = 0; i < instance_count; ++i) {
+            this->shadeVertices(shaders, instances[i]);
+            this->clipTris(tris, transform, draw);
+        }
+    } catch (...) {
+        this->discardPass();
+        throw;
+    }
+}
+
+inline float evaluatePlane(const AttributePlane& plane, float x, float y) {
+    return (plane.a * x) + (plane.b * y) + plane.c;
+}
+
+// evaluates a plane at every lane of a quad whose top-left pixel is (x, y) relative to the origin
+inline Float4 evaluatePlaneQuad(const AttributePlane& plane, float x, float y) {
+    float value = evaluatePlane(plane, x, y);
+    return Float4::set(value, value + plane.a, value + plane.b, value + plane.a + plane.b);
+}
+
+// evaluates depth and the perspective-correct varyings of a primitive at every lane of a quad
+inline void interpolateQuad(const AttributeSetup& setup, QuadInput& quad) {
+    float x = static_cast<float>(static_cast<int32_t>(quad.position.x) - setup.origin_x);
+    float y = static_cast<float>(static_cast<int32_t>(quad.position.y) - setup.origin_y);
+
+    quad.depth = evaluatePlaneQuad(setup.depth, x, y);
+
+    Float4 w = Float4::broadcast(1.0f) / evaluatePlaneQuad(setup.inverse_w, x, y);
+    for (uint32_t i = 0; i < setup.varying_count; ++i) {
+        quad.varyings[i] = evaluatePlaneQuad(setup.varyings[i], x, y) * w;
+    }
+}
+
+template<ShaderProgram S>
+std::vector<S>& ShaderPassProgram<S>::getWorkerShaders() {
+    return this->worker_shaders;
+}
+
+template<ShaderProgram S>
+size_t ShaderPassProgram<S>::getWorkerCount() {
+    return this->worker_shaders.size();
+}
+
+// runs the fragment shader on the lanes of a quad covered by one primitive
+template<ShaderProgram S>
+void ShaderPassProgram<S>::shadeQuad(size_t worker, const QuadInput& input, const AttributeSetup& attributes, Vector4f colors[4]) {
+    S& shader = this->worker_shaders[worker];
+
+    if constexpr (QuadFragmentShader<S>) {
+        QuadOutput output;
+        shader.fragmentQuad(input, output);
+        transpose4x4(output.color[0], output.color[1], output.color[2], output.color[3]);
+
+        for (uint32_t lane = 0; lane < 4; ++lane) {
+            output.color[lane].store(colors[lane].data);
+        }
+    } else {
+        float depths[4];
+        float varyings[MAX_VARYINGS][4];
+        input.depth.store(depths);
+        for (uint32_t i = 0; i < attributes.varying_count; ++i) {
+            input.varyings[i].store(varyings[i]);
+        }
+
+        for (uint32_t lane = 0; lane < 4; ++lane) {
+            if (input.mask & (1u << lane)) {
+                FragmentInput fragment;
+                fragment.position = Vector2u(input.position.x + (lane & 1), input.position.y + (lane >> 1));
+                fragment.depth = depths[lane];
+                for (uint32_t i = 0; i < attributes.varying_count; ++i) {
+                    fragment.varyings[i] = varyings[i][lane];
+                }
+                colors[lane] = shader.fragment(fragment);
+            }
+        }
+    }
+}
+
 } // namespace apparition
 
 #endif // APPARITION_RENDERER_HH
\ No newline at end of file
@@ -18,6 +18,9 @@
 #ifndef APPARITION_SHADER_HH
 #define APPARITION_SHADER_HH
 
+#include <algorithm>
+#include <memory>
+
 #include "renderer.hh"
 
 namespace apparition {
@@ -27,13 +30,41 @@ class Shader {
         Vertex* vertex;
         Vector2u in_fragment_position;
         float in_fragment_depth;
-        Vector4f varying_vertex_color;
+        float in_fragment_varyings[MAX_VARYINGS];
         Vector4f out_fragment_color;
         Shader() = default;
+        virtual ~Shader() = default;
+        // returns a new instance for another render thread, or nullptr to keep shading on one thread
+        virtual std::unique_ptr<Shader> clone() const { return nullptr; }
         virtual void runVertex() {}
         virtual void runFragment() {}
 };
 
+// runs a virtual Shader through the templated draw path, every invocation goes through
+// the shader's member fields and virtual calls
+class ShaderAdapter {
+    public:
+        ShaderAdapter(Shader* shader) : shader(shader) {}
+        void vertex(Vertex& vertex);
+        Vector4f fragment(const FragmentInput& fragment);
+    private:
+        Shader* shader;
+};
+
+inline void ShaderAdapter::vertex(Vertex& vertex) {
+    this->shader->vertex = &vertex;
+    this->shader->runVertex();
+}
+
+inline Vector4f ShaderAdapter::fragment(const FragmentInput& fragment) {
+    this->shader->in_fragment_position = fragment.position;
+    this->shader->in_fragment_depth = fragment.depth;
+    std::copy(fragment.varyings, fragment.varyings + MAX_VARYINGS, this->shader->in_fragment_varyings);
+    this->shader->out_fragment_color = Vector4f();
+    this->shader->runFragment();
+    return this->shader->out_fragment_color;
+}
+
 } // namespace apparition
 
 #endif // APPARITION_SHADER_HH
\ No newline at end of file
@@ -0,0 +1,312 @@
+// codeshaunted - apparition
+// include/apparition/simd.hh
+// contains simd declarations
+// Copyright 2024 codeshaunted
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org / licenses / LICENSE - 2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissionsand
+// limitations under the License.
+
+#ifndef APPARITION_SIMD_HH
+#define APPARITION_SIMD_HH
+
+#include <algorithm>
+#include <cstdint>
+
+// sse is used whenever the target has it unless APPARITION_NO_SIMD is defined,
+// every operation has a scalar fallback with identical results
+#if defined(__SSE2__) && !defined(APPARITION_NO_SIMD)
+#define APPARITION_SSE 1
+#include <immintrin.h>
+#endif
+
+#if defined(__AVX__) && !defined(APPARITION_NO_SIMD)
+#define APPARITION_AVX 1
+#endif
+
+namespace apparition {
+
+// four packed floats
+struct Float4 {
+#ifdef APPARITION_SSE
+    __m128 value;
+#else
+    float value[4];
+#endif
+    static Float4 load(const float* source);
+    static Float4 broadcast(float scalar);
+    static Float4 set(float lane_0, float lane_1, float lane_2, float lane_3);
+    void store(float* destination) const;
+    float get(size_t lane) const;
+    float sum() const;
+};
+
+inline Float4 Float4::load(const float* source) {
+    Float4 result;
+#ifdef APPARITION_SSE
+    result.value = _mm_loadu_ps(source);
+#else
+    for (size_t i = 0; i < 4; ++i) {
+        result.value[i] = source[i];
+    }
+#endif
+    return result;
+}
+
+inline Float4 Float4::broadcast(float scalar) {
+    Float4 result;
+#ifdef APPARITION_SSE
+    result.value = _mm_set1_ps(scalar);
+#else
+    for (size_t i = 0; i < 4; ++i) {
+        result.value[i] = scalar;
+    }
+#endif
+    return result;
+}
+
+inline Float4 Float4::set(float lane_0, float lane_1, float lane_2, float lane_3) {
+    Float4 result;
+#ifdef APPARITION_SSE
+    result.value = _mm_setr_ps(lane_0, lane_1, lane_2, lane_3);
+#else
+    result.value[0] = lane_0;
+    result.value[1] = lane_1;
+    result.value[2] = lane_2;
+    result.value[3] = lane_3;
+#endif
+    return result;
+}
+
+inline void Float4::store(float* destination) const {
+#ifdef APPARITION_SSE
+    _mm_storeu_ps(destination, this->value);
+#else
+    for (size_t i = 0; i < 4; ++i) {
+        destination[i] = this->value[i];
+    }
+#endif
+}
+
+inline float Float4::get(size_t lane) const {
+    float lanes[4];
+    this->store(lanes);
+    return lanes[lane];
+}
+
+inline float Float4::sum() const {
+#ifdef APPARITION_SSE
+    __m128 shuffled = _mm_shuffle_ps(this->value, this->value, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(this->value, shuffled);
+    shuffled = _mm_movehl_ps(shuffled, sums);
+    return _mm_cvtss_f32(_mm_add_ss(sums, shuffled));
+#else
+    return (this->value[0] + this->value[1]) + (this->value[2] + this->value[3]);
+#endif
+}
+
+inline Float4 operator+(Float4 left, Float4 right) {
+#ifdef APPARITION_SSE
+    return {_mm_add_ps(left.value, right.value)};
+#else
+    Float4 result;
+    for (size_t i = 0; i < 4; ++i) {
+        result.value[i] = left.value[i] + right.value[i];
+    }
+    return result;
+#endif
+}
+
+inline Float4 operator-(Float4 left, Float4 right) {
+#ifdef APPARITION_SSE
+    return {_mm_sub_ps(left.value, right.value)};
+#else
+    Float4 result;
+    for (size_t i = 0; i < 4; ++i) {
+        result.value[i] = left.value[i] - right.value[i];
+    }
+    return result;
+#endif
+}
+
+inline Float4 operator*(Float4 left, Float4 right) {
+#ifdef APPARITION_SSE
+    return {_mm_mul_ps(left.value, right.value)};
+#else
+    Float4 result;
+    for (size_t i = 0; i < 4; ++i) {
+        result.value[i] = left.value[i] * right.value[i];
+    }
+    return result;
+#endif
+}
+
+inline Float4 operator/(Float4 left, Float4 right) {
+#ifdef APPARITION_SSE
+    return {_mm_div_ps(left.value, right.value)};
+#else
+    Float4 result;
+    for (size_t i = 0; i < 4; ++i) {
+        result.value[i] = left.value[i] / right.value[i];
+    }
+    return result;
+#endif
+}
+
+inline Float4 min(Float4 left, Float4 right) {
+#ifdef APPARITION_SSE
+    return {_mm_min_ps(left.value, right.value)};
+#else
+    Float4 result;
+    for (size_t i = 0; i < 4; ++i) {
+        result.value[i] = std::min(left.value[i], right.value[i]);
+    }
+    return result;
+#endif
+}
+
+inline Float4 max(Float4 left, Float4 right) {
+#ifdef APPARITION_SSE
+    return {_mm_max_ps(left.value, right.value)};
+#else
+    Float4 result;
+    for (size_t i = 0; i < 4; ++i) {
+        result.value[i] = std::max(left.value[i], right.value[i]);
+    }
+    return result;
+#endif
+}
+
+// picks lanes of 'source' by index, e.g. shuffle<1, 1, 3, 3> duplicates the odd lanes
+template<int L0, int L1, int L2, int L3>
+inline Float4 shuffle(Float4 source) {
+#ifdef APPARITION_SSE
+    return {_mm_shuffle_ps(source.value, source.value, _MM_SHUFFLE(L3, L2, L1, L0))};
+#else
+    return Float4::set(source.value[L0], source.value[L1], source.value[L2], source.value[L3]);
+#endif
+}
+
+// transposes four rows of four floats in place
+inline void transpose4x4(Float4& row_0, Float4& row_1, Float4& row_2, Float4& row_3) {
+#ifdef APPARITION_SSE
+    _MM_TRANSPOSE4_PS(row_0.value, row_1.value, row_2.value, row_3.value);
+#else
+    Float4* rows[4] = {&row_0, &row_1, &row_2, &row_3};
+    for (size_t i = 0; i < 4; ++i) {
+        for (size_t j = i + 1; j < 4; ++j) {
+            std::swap(rows[i]->value[j], rows[j]->value[i]);
+        }
+    }
+#endif
+}
+
+// rounds four floats to 8-bit unorm values packed from the lowest byte up, values outside of
+// [0, 1] are clamped and nan becomes zero
+inline uint32_t packUnorm8(Float4 value) {
+#ifdef APPARITION_SSE
+    __m128 clamped = _mm_min_ps(_mm_max_ps(value.value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    __m128i integers = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(clamped, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+    integers = _mm_packs_epi32(integers, integers);
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_packus_epi16(integers, integers)));
+#else
+    uint32_t packed = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        float clamped = value.value[i] > 0.0f ? std::min(value.value[i], 1.0f) : 0.0f;
+        packed |= static_cast<uint32_t>((clamped * 255.0f) + 0.5f) << (i * 8);
+    }
+    return packed;
+#endif
+}
+
+// four packed 64-bit integers, wide enough to evaluate edge functions exactly
+struct Long4 {
+#ifdef APPARITION_SSE
+    __m128i low;
+    __m128i high;
+#else
+    int64_t value[4];
+#endif
+    static Long4 set(int64_t lane_0, int64_t lane_1, int64_t lane_2, int64_t lane_3);
+    static Long4 broadcast(int64_t scalar);
+    uint32_t signMask() const;
+    Float4 toFloat4() const;
+};
+
+inline Long4 Long4::set(int64_t lane_0, int64_t lane_1, int64_t lane_2, int64_t lane_3) {
+    Long4 result;
+#ifdef APPARITION_SSE
+    result.low = _mm_set_epi64x(lane_1, lane_0);
+    result.high = _mm_set_epi64x(lane_3, lane_2);
+#else
+    result.value[0] = lane_0;
+    result.value[1] = lane_1;
+    result.value[2] = lane_2;
+    result.value[3] = lane_3;
+#endif
+    return result;
+}
+
+inline Long4 Long4::broadcast(int64_t scalar) {
+    return Long4::set(scalar, scalar, scalar, scalar);
+}
+
+// bit i is set if lane i is negative
+inline uint32_t Long4::signMask() const {
+#ifdef APPARITION_SSE
+    return _mm_movemask_pd(_mm_castsi128_pd(this->low)) | (_mm_movemask_pd(_mm_castsi128_pd(this->high)) << 2);
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        mask |= (this->value[i] < 0 ? 1u : 0u) << i;
+    }
+    return mask;
+#endif
+}
+
+inline Float4 Long4::toFloat4() const {
+#ifdef APPARITION_SSE
+    alignas(16) int64_t lanes[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), this->low);
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes + 2), this->high);
+    return Float4::set(static_cast<float>(lanes[0]), static_cast<float>(lanes[1]), static_cast<float>(lanes[2]), static_cast<float>(lanes[3]));
+#else
+    return Float4::set(static_cast<float>(this->value[0]), static_cast<float>(this->value[1]), static_cast<float>(this->value[2]), static_cast<float>(this->value[3]));
+#endif
+}
+
+inline Long4 operator+(Long4 left, Long4 right) {
+#ifdef APPARITION_SSE
+    return {_mm_add_epi64(left.low, right.low), _mm_add_epi64(left.high, right.high)};
+#else
+    Long4 result;
+    for (size_t i = 0; i < 4; ++i) {
+        result.value[i] = left.value[i] + right.value[i];
+    }
+    return result;
+#endif
+}
+
+inline Long4 operator|(Long4 left, Long4 right) {
+#ifdef APPARITION_SSE
+    return {_mm_or_si128(left.low, right.low), _mm_or_si128(left.high, right.high)};
+#else
+    Long4 result;
+    for (size_t i = 0; i < 4; ++i) {
+        result.value[i] = left.value[i] | right.value[i];
+    }
+    return result;
+#endif
+}
+
+} // namespace apparition
+
+#endif // APPARITION_SIMD_HH
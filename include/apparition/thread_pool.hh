@@ -0,0 +1,58 @@
+// codeshaunted - apparition
+// include/apparition/thread_pool.hh
+// contains thread pool declarations
+// Copyright 2024 codeshaunted
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org / licenses / LICENSE - 2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissionsand
+// limitations under the License.
+
+#ifndef APPARITION_THREAD_POOL_HH
+#define APPARITION_THREAD_POOL_HH
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace apparition {
+
+// runs batches of tasks on a fixed set of threads, the calling thread
+// participates as worker 0 so a pool of one thread spawns nothing
+class ThreadPool {
+    public:
+        ThreadPool(size_t thread_count);
+        ~ThreadPool();
+        size_t getThreadCount();
+        void run(size_t task_count, const std::function<void(size_t task, size_t worker)>& task);
+    private:
+        void work(size_t worker);
+        void drain(size_t worker);
+        std::vector<std::thread> threads;
+        std::mutex mutex;
+        std::condition_variable start_condition;
+        std::condition_variable done_condition;
+        const std::function<void(size_t task, size_t worker)>* job;
+        size_t task_count;
+        std::atomic<size_t> next_task;
+        size_t active_workers;
+        uint64_t generation;
+        bool stopping;
+        std::exception_ptr exception;
+};
+
+} // namespace apparition
+
+#endif // APPARITION_THREAD_POOL_HH
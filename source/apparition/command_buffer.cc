@@ -0,0 +1,146 @@
+// codeshaunted - apparition
+// source/apparition/command_buffer.cc
+// contains command buffer definitions
+// Copyright 2024 codeshaunted
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org / licenses / LICENSE - 2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissionsand
+// limitations under the License.
+
+#include <stdexcept>
+
+#include "command_buffer.hh"
+
+namespace apparition {
+
+void CommandBuffer::setDepthFunction(DepthFunction depth_function) {
+    this->commands.push_back([depth_function](Renderer& renderer) {
+        renderer.setDepthFunction(depth_function);
+    });
+}
+
+void CommandBuffer::setDepthWrite(bool depth_write) {
+    this->commands.push_back([depth_write](Renderer& renderer) {
+        renderer.setDepthWrite(depth_write);
+    });
+}
+
+void CommandBuffer::setVertexLayout(VertexLayout vertex_layout) {
+    this->commands.push_back([vertex_layout](Renderer& renderer) {
+        renderer.setVertexLayout(vertex_layout);
+    });
+}
+
+void CommandBuffer::setViewport(Viewport viewport) {
+    this->commands.push_back([viewport](Renderer& renderer) {
+        renderer.setViewport(viewport);
+    });
+}
+
+void CommandBuffer::setCullMode(CullMode cull_mode) {
+    this->commands.push_back([cull_mode](Renderer& renderer) {
+        renderer.setCullMode(cull_mode);
+    });
+}
+
+void CommandBuffer::setFrontFace(FrontFace front_face) {
+    this->commands.push_back([front_face](Renderer& renderer) {
+        renderer.setFrontFace(front_face);
+    });
+}
+
+void CommandBuffer::setLineMode(LineMode line_mode) {
+    this->commands.push_back([line_mode](Renderer& renderer) {
+        renderer.setLineMode(line_mode);
+    });
+}
+
+void CommandBuffer::bindFrameBuffer(FrameBuffer* to_bind) {
+    if (!to_bind) {
+        throw std::invalid_argument("'to_bind' cannot be nullptr");
+    }
+
+    this->commands.push_back([to_bind](Renderer& renderer) {
+        renderer.bindFrameBuffer(to_bind);
+    });
+}
+
+void CommandBuffer::bindVertexBuffer(std::vector<Vertex>* to_bind) {
+    if (!to_bind) {
+        throw std::invalid_argument("'to_bind' cannot be nullptr");
+    }
+
+    this->commands.push_back([to_bind](Renderer& renderer) {
+        renderer.bindVertexBuffer(to_bind);
+    });
+}
+
+void CommandBuffer::bindIndexBuffer(std::vector<uint16_t>* to_bind) {
+    if (!to_bind) {
+        throw std::invalid_argument("'to_bind' cannot be nullptr");
+    }
+
+    this->commands.push_back([to_bind](Renderer& renderer) {
+        renderer.bindIndexBuffer(to_bind);
+    });
+}
+
+void CommandBuffer::bindIndexBuffer(std::vector<uint32_t>* to_bind) {
+    if (!to_bind) {
+        throw std::invalid_argument("'to_bind' cannot be nullptr");
+    }
+
+    this->commands.push_back([to_bind](Renderer& renderer) {
+        renderer.bindIndexBuffer(to_bind);
+    });
+}
+
+void CommandBuffer::bindIndexBuffer(std::vector<size_t>* to_bind) {
+    if (!to_bind) {
+        throw std::invalid_argument("'to_bind' cannot be nullptr");
+    }
+
+    this->commands.push_back([to_bind](Renderer& renderer) {
+        renderer.bindIndexBuffer(to_bind);
+    });
+}
+
+void CommandBuffer::unbindIndexBuffer() {
+    this->commands.push_back([](Renderer& renderer) {
+        renderer.unbindIndexBuffer();
+    });
+}
+
+void CommandBuffer::clear(Vector4f color, float depth) {
+    this->commands.push_back([color, depth](Renderer& renderer) {
+        renderer.clear(color, depth);
+    });
+}
+
+void CommandBuffer::resolve(ColorBuffer* destination) {
+    if (!destination) {
+        throw std::invalid_argument("'destination' cannot be nullptr");
+    }
+
+    this->commands.push_back([destination](Renderer& renderer) {
+        renderer.resolve(destination);
+    });
+}
+
+size_t CommandBuffer::getCommandCount() {
+    return this->commands.size();
+}
+
+void CommandBuffer::reset() {
+    this->commands.clear();
+}
+
+} // namespace apparition
@@ -0,0 +1,543 @@
+// codeshaunted - apparition
+// source/apparition/image.cc
+// contains image encoder definitions
+// Copyright 2024 codeshaunted
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org / licenses / LICENSE - 2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissionsand
+// limitations under the License.
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+#include "image.hh"
+
+namespace apparition {
+
+constexpr size_t DEFLATE_WINDOW_SIZE = 32768;
+constexpr uint32_t DEFLATE_HASH_BITS = 15;
+constexpr size_t DEFLATE_MIN_MATCH = 4;
+constexpr size_t DEFLATE_MAX_MATCH = 258;
+
+// bytes collected before they are written to the file or wrapped into a png data chunk
+constexpr size_t IMAGE_OUTPUT_BLOCK_SIZE = 1 << 20;
+constexpr size_t PNG_CHUNK_SIZE = 1 << 18;
+
+static const uint16_t LENGTH_BASES[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t LENGTH_EXTRA_BITS[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t DISTANCE_BASES[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t DISTANCE_EXTRA_BITS[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+// the fixed huffman codes of deflate bit-reversed for the lsb-first bit stream, and the length
+// and distance code of every match length and distance
+struct FixedCodes {
+    uint16_t literal_codes[288];
+    uint8_t literal_lengths[288];
+    uint8_t distance_codes[30];
+    uint8_t length_indices[DEFLATE_MAX_MATCH + 1];
+    uint8_t near_distance_indices[256];
+    uint8_t far_distance_indices[256];
+};
+
+static uint32_t reverseBits(uint32_t bits, uint32_t count) {
+    uint32_t reversed = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        reversed |= ((bits >> i) & 1) << (count - 1 - i);
+    }
+    return reversed;
+}
+
+static FixedCodes buildFixedCodes() {
+    FixedCodes codes;
+    for (uint32_t literal = 0; literal < 288; ++literal) {
+        uint32_t code;
+        uint32_t length;
+        if (literal < 144) {
+            code = 0x30 + literal;
+            length = 8;
+        } else if (literal < 256) {
+            code = 0x190 + (literal - 144);
+            length = 9;
+        } else if (literal < 280) {
+            code = literal - 256;
+            length = 7;
+        } else {
+            code = 0xC0 + (literal - 280);
+            length = 8;
+        }
+        codes.literal_codes[literal] = static_cast<uint16_t>(reverseBits(code, length));
+        codes.literal_lengths[literal] = static_cast<uint8_t>(length);
+    }
+
+    for (uint32_t index = 0; index < 30; ++index) {
+        codes.distance_codes[index] = static_cast<uint8_t>(reverseBits(index, 5));
+    }
+
+    for (uint32_t index = 0; index < 29; ++index) {
+        for (uint32_t length = LENGTH_BASES[index]; length < LENGTH_BASES[index] + (1u << LENGTH_EXTRA_BITS[index]) && length <= DEFLATE_MAX_MATCH; ++length) {
+            codes.length_indices[length] = static_cast<uint8_t>(index);
+        }
+    }
+
+    // distances past 256 share their code with every distance in the same 128 wide step
+    for (uint32_t index = 0; index < 30; ++index) {
+        for (uint32_t distance = DISTANCE_BASES[index] - 1; distance < DISTANCE_BASES[index] - 1 + (1u << DISTANCE_EXTRA_BITS[index]); ++distance) {
+            if (distance < 256) {
+                codes.near_distance_indices[distance] = static_cast<uint8_t>(index);
+            } else {
+                codes.far_distance_indices[distance >> 7] = static_cast<uint8_t>(index);
+            }
+        }
+    }
+
+    return codes;
+}
+
+static const FixedCodes& getFixedCodes() {
+    static const FixedCodes codes = buildFixedCodes();
+    return codes;
+}
+
+// the zlib header and the header of the single fixed huffman block start out in the bit buffer
+Deflater::Deflater() {
+    this->head.resize(size_t(1) << DEFLATE_HASH_BITS, 0);
+    this->window_start = 0;
+    this->position = 0;
+    this->bit_buffer = 0x78 | (0x01 << 8) | (0x3 << 16);
+    this->bit_count = 19;
+    this->adler_a = 1;
+    this->adler_b = 0;
+}
+
+// bytes are encoded once the following bytes a match could cover have arrived, the rest waits for
+// the next call or finish
+void Deflater::compress(const uint8_t* data, size_t size, std::vector<uint8_t>& output) {
+    if (!data && size > 0) {
+        throw std::invalid_argument("'data' cannot be nullptr");
+    }
+
+    // the sums are reduced before they can overflow 32 bits
+    for (size_t offset = 0; offset < size; offset += 5552) {
+        size_t end = std::min(size, offset + 5552);
+        for (size_t i = offset; i < end; ++i) {
+            this->adler_a += data[i];
+            this->adler_b += this->adler_a;
+        }
+        this->adler_a %= 65521;
+        this->adler_b %= 65521;
+    }
+
+    this->window.insert(this->window.end(), data, data + size);
+    size_t total = this->window_start + this->window.size();
+    if (total >= DEFLATE_MIN_MATCH) {
+        this->encode(total - DEFLATE_MIN_MATCH + 1, output);
+    }
+
+    // only the last window size of encoded bytes can still be referenced
+    size_t encoded = this->position - this->window_start;
+    if (encoded > 2 * DEFLATE_WINDOW_SIZE) {
+        size_t dropped = encoded - DEFLATE_WINDOW_SIZE;
+        this->window.erase(this->window.begin(), this->window.begin() + dropped);
+        this->window_start += dropped;
+    }
+}
+
+void Deflater::finish(std::vector<uint8_t>& output) {
+    this->encode(this->window_start + this->window.size(), output);
+    this->writeLiteral(256, output);
+    if (this->bit_count % 8) {
+        this->writeBits(0, 8 - (this->bit_count % 8), output);
+    }
+
+    uint32_t adler = (this->adler_b << 16) | this->adler_a;
+    for (int32_t shift = 24; shift >= 0; shift -= 8) {
+        output.push_back(static_cast<uint8_t>(adler >> shift));
+    }
+}
+
+// greedy matching against the last position with the same hash of the next four bytes
+void Deflater::encode(size_t end, std::vector<uint8_t>& output) {
+    size_t total = this->window_start + this->window.size();
+    while (this->position < end) {
+        const uint8_t* current = this->window.data() + (this->position - this->window_start);
+        if (this->position + DEFLATE_MIN_MATCH > total) {
+            this->writeLiteral(*current, output);
+            ++this->position;
+            continue;
+        }
+
+        uint32_t bytes;
+        std::memcpy(&bytes, current, 4);
+        uint32_t hash = (bytes * 2654435761u) >> (32 - DEFLATE_HASH_BITS);
+        size_t candidate = this->head[hash];
+        this->head[hash] = this->position + 1;
+
+        if (candidate > this->window_start && this->position - (candidate - 1) <= DEFLATE_WINDOW_SIZE) {
+            const uint8_t* match = this->window.data() + (candidate - 1 - this->window_start);
+            size_t limit = std::min(DEFLATE_MAX_MATCH, total - this->position);
+            size_t length = 0;
+            while (length + 8 <= limit) {
+                uint64_t left;
+                uint64_t right;
+                std::memcpy(&left, match + length, 8);
+                std::memcpy(&right, current + length, 8);
+                if (left != right) {
+                    length += std::countr_zero(left ^ right) / 8;
+                    break;
+                }
+                length += 8;
+            }
+            while (length < limit && match[length] == current[length]) {
+                ++length;
+            }
+
+            if (length >= DEFLATE_MIN_MATCH) {
+                this->writeMatch(static_cast<uint32_t>(length), static_cast<uint32_t>(this->position - (candidate - 1)), output);
+                this->position += length;
+                continue;
+            }
+        }
+
+        this->writeLiteral(*current, output);
+        ++this->position;
+    }
+}
+
+void Deflater::writeBits(uint32_t bits, uint32_t count, std::vector<uint8_t>& output) {
+    this->bit_buffer |= static_cast<uint64_t>(bits) << this->bit_count;
+    this->bit_count += count;
+    while (this->bit_count >= 8) {
+        output.push_back(static_cast<uint8_t>(this->bit_buffer));
+        this->bit_buffer >>= 8;
+        this->bit_count -= 8;
+    }
+}
+
+void Deflater::writeLiteral(uint32_t literal, std::vector<uint8_t>& output) {
+    const FixedCodes& codes = getFixedCodes();
+    this->writeBits(codes.literal_codes[literal], codes.literal_lengths[literal], output);
+}
+
+void Deflater::writeMatch(uint32_t length, uint32_t distance, std::vector<uint8_t>& output) {
+    const FixedCodes& codes = getFixedCodes();
+    uint32_t length_index = codes.length_indices[length];
+    this->writeLiteral(257 + length_index, output);
+    this->writeBits(length - LENGTH_BASES[length_index], LENGTH_EXTRA_BITS[length_index], output);
+
+    uint32_t distance_index = distance <= 256 ? codes.near_distance_indices[distance - 1] : codes.far_distance_indices[(distance - 1) >> 7];
+    this->writeBits(codes.distance_codes[distance_index], 5, output);
+    this->writeBits(distance - DISTANCE_BASES[distance_index], DISTANCE_EXTRA_BITS[distance_index], output);
+}
+
+static uint32_t updateCrc(uint32_t crc, const uint8_t* data, size_t size) {
+    static const auto TABLE = [] {
+        std::vector<uint32_t> table(256);
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t value = i;
+            for (uint32_t bit = 0; bit < 8; ++bit) {
+                value = (value & 1) ? 0xEDB88320 ^ (value >> 1) : value >> 1;
+            }
+            table[i] = value;
+        }
+        return table;
+    }();
+
+    for (size_t i = 0; i < size; ++i) {
+        crc = TABLE[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+static void appendBigEndian(std::vector<uint8_t>& output, uint32_t value) {
+    for (int32_t shift = 24; shift >= 0; shift -= 8) {
+        output.push_back(static_cast<uint8_t>(value >> shift));
+    }
+}
+
+static void appendLittleEndian(std::vector<uint8_t>& output, uint16_t value) {
+    output.push_back(static_cast<uint8_t>(value));
+    output.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+// tga rows are written from the top as well, the image descriptor flags the top-left origin
+ImageWriter::ImageWriter(const std::string& path, Vector2u dimensions, ImageFormat format) {
+    if (dimensions.x == 0 || dimensions.y == 0) {
+        throw std::invalid_argument("'dimensions' cannot be zero");
+    }
+
+    bool tga = format == ImageFormat::TGA || format == ImageFormat::TGA_RLE;
+    if (tga && (dimensions.x > 0xFFFF || dimensions.y > 0xFFFF)) {
+        throw std::invalid_argument("tga images are limited to 65535 pixels on either side");
+    }
+
+    if (format == ImageFormat::PNG && (dimensions.x > 0x7FFFFFFF || dimensions.y > 0x7FFFFFFF)) {
+        throw std::invalid_argument("png images are limited to 2147483647 pixels on either side");
+    }
+
+    this->file.open(path, std::ios::binary | std::ios::trunc);
+    if (!this->file.is_open()) {
+        throw std::runtime_error("Failed to open '" + path + "' for writing");
+    }
+
+    this->dimensions = dimensions;
+    this->format = format;
+    this->next_row = 0;
+    this->finished = false;
+    this->row.resize(static_cast<size_t>(dimensions.x) * 4);
+    this->output.reserve(IMAGE_OUTPUT_BLOCK_SIZE + (this->row.size() * 2));
+
+    switch (format) {
+        case ImageFormat::TGA:
+        case ImageFormat::TGA_RLE: {
+            uint8_t header[12] = {};
+            header[2] = format == ImageFormat::TGA_RLE ? 10 : 2;
+            this->output.insert(this->output.end(), header, header + 12);
+            appendLittleEndian(this->output, static_cast<uint16_t>(dimensions.x));
+            appendLittleEndian(this->output, static_cast<uint16_t>(dimensions.y));
+            this->output.push_back(32);
+            this->output.push_back(0x28);
+            break;
+        }
+        case ImageFormat::PPM: {
+            std::string header = "P6\n" + std::to_string(dimensions.x) + " " + std::to_string(dimensions.y) + "\n255\n";
+            this->output.insert(this->output.end(), header.begin(), header.end());
+            break;
+        }
+        case ImageFormat::PNG: {
+            static const uint8_t SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+            this->output.insert(this->output.end(), SIGNATURE, SIGNATURE + 8);
+
+            // 8-bit rgba, deflate, adaptive filtering and no interlacing
+            std::vector<uint8_t> header;
+            appendBigEndian(header, dimensions.x);
+            appendBigEndian(header, dimensions.y);
+            header.insert(header.end(), {8, 6, 0, 0, 0});
+            this->writeChunk("IHDR", header.data(), header.size());
+
+            this->previous_row.resize(this->row.size(), 0);
+            this->compressed.reserve(PNG_CHUNK_SIZE + (this->row.size() * 2));
+            break;
+        }
+    }
+}
+
+Vector2u ImageWriter::getDimensions() {
+    return this->dimensions;
+}
+
+uint32_t ImageWriter::getRemainingRows() {
+    return this->dimensions.y - this->next_row;
+}
+
+// encodes the next row_count rows from the top of a color buffer with the dimensions of the image,
+// rgba8 buffers are copied as they are stored and rgba32f buffers packed straight from memory, other
+// formats and multisampled buffers go through load which unpacks and averages the samples
+void ImageWriter::writeRows(ColorBuffer* color_buffer, uint32_t row_count) {
+    if (!color_buffer) {
+        throw std::invalid_argument("'color_buffer' cannot be nullptr");
+    }
+
+    Vector2u buffer_dimensions = color_buffer->getDimensions();
+    if (buffer_dimensions.x != this->dimensions.x || buffer_dimensions.y != this->dimensions.y) {
+        throw std::invalid_argument("'color_buffer' has to match the dimensions of the image");
+    }
+
+    if (this->finished) {
+        throw std::logic_error("Image already finished");
+    }
+
+    if (row_count > this->getRemainingRows()) {
+        throw std::invalid_argument("'row_count' exceeds the rows left in the image");
+    }
+
+    const uint8_t* data = color_buffer->getData();
+    size_t stride = color_buffer->getStride();
+    bool single_sampled = color_buffer->getSampleCount() == 1;
+    bool packed = single_sampled && color_buffer->getFormat() == ColorFormat::RGBA8_UNORM;
+    bool floats = single_sampled && color_buffer->getFormat() == ColorFormat::RGBA32F;
+    for (uint32_t i = 0; i < row_count; ++i) {
+        uint32_t y = this->dimensions.y - 1 - this->next_row;
+        if (packed) {
+            // both layouts keep the pixels of a block row next to each other
+            for (uint32_t x = 0; x < this->dimensions.x; x += BUFFER_BLOCK_SIZE) {
+                size_t count = std::min(BUFFER_BLOCK_SIZE, this->dimensions.x - x);
+                std::memcpy(this->row.data() + (static_cast<size_t>(x) * 4), data + (color_buffer->getIndex(Vector2u(x, y)) * stride), count * 4);
+            }
+        } else if (floats) {
+            for (uint32_t x = 0; x < this->dimensions.x; x += BUFFER_BLOCK_SIZE) {
+                uint32_t count = std::min(BUFFER_BLOCK_SIZE, this->dimensions.x - x);
+                const uint8_t* source = data + (color_buffer->getIndex(Vector2u(x, y)) * stride);
+                for (uint32_t pixel = 0; pixel < count; ++pixel) {
+                    float channels[4];
+                    std::memcpy(channels, source + (pixel * stride), sizeof(channels));
+                    uint32_t color = packUnorm8(Float4::load(channels));
+                    std::memcpy(this->row.data() + (static_cast<size_t>(x + pixel) * 4), &color, 4);
+                }
+            }
+        } else {
+            for (uint32_t x = 0; x < this->dimensions.x; ++x) {
+                uint32_t color = packUnorm8(Float4::load(color_buffer->load(color_buffer->getIndex(Vector2u(x, y))).data));
+                std::memcpy(this->row.data() + (static_cast<size_t>(x) * 4), &color, 4);
+            }
+        }
+
+        this->encodeRow();
+        ++this->next_row;
+    }
+}
+
+// completes the file once every row is written
+void ImageWriter::finish() {
+    if (this->finished) {
+        return;
+    }
+
+    if (this->next_row != this->dimensions.y) {
+        throw std::logic_error("Image has rows left to write");
+    }
+
+    if (this->format == ImageFormat::PNG) {
+        this->deflater.finish(this->compressed);
+        this->writeChunk("IDAT", this->compressed.data(), this->compressed.size());
+        this->compressed.clear();
+        this->writeChunk("IEND", nullptr, 0);
+    }
+
+    this->flush();
+    this->file.close();
+    if (this->file.fail()) {
+        throw std::runtime_error("Failed to write image");
+    }
+
+    this->finished = true;
+}
+
+// converts the rgba row to the pixel order of the format and appends it to the output
+void ImageWriter::encodeRow() {
+    uint32_t width = this->dimensions.x;
+    uint8_t* pixels = this->row.data();
+    switch (this->format) {
+        case ImageFormat::TGA:
+        case ImageFormat::TGA_RLE: {
+            for (uint32_t x = 0; x < width; ++x) {
+                std::swap(pixels[(x * 4) + 0], pixels[(x * 4) + 2]);
+            }
+
+            if (this->format == ImageFormat::TGA) {
+                this->output.insert(this->output.end(), pixels, pixels + (static_cast<size_t>(width) * 4));
+                break;
+            }
+
+            // runs of equal pixels become run packets, everything between them raw packets,
+            // packets hold up to 128 pixels and never cross a row
+            auto pixel = [pixels](uint32_t x) {
+                uint32_t value;
+                std::memcpy(&value, pixels + (static_cast<size_t>(x) * 4), 4);
+                return value;
+            };
+
+            uint32_t x = 0;
+            while (x < width) {
+                uint32_t run = 1;
+                while (x + run < width && run < 128 && pixel(x + run) == pixel(x)) {
+                    ++run;
+                }
+
+                if (run > 1) {
+                    this->output.push_back(static_cast<uint8_t>(0x80 | (run - 1)));
+                    this->output.insert(this->output.end(), pixels + (static_cast<size_t>(x) * 4), pixels + (static_cast<size_t>(x) * 4) + 4);
+                    x += run;
+                    continue;
+                }
+
+                uint32_t raw = 1;
+                while (x + raw < width && raw < 128 && !(x + raw + 1 < width && pixel(x + raw) == pixel(x + raw + 1))) {
+                    ++raw;
+                }
+
+                this->output.push_back(static_cast<uint8_t>(raw - 1));
+                this->output.insert(this->output.end(), pixels + (static_cast<size_t>(x) * 4), pixels + (static_cast<size_t>(x + raw) * 4));
+                x += raw;
+            }
+            break;
+        }
+        case ImageFormat::PPM: {
+            size_t offset = this->output.size();
+            this->output.resize(offset + (static_cast<size_t>(width) * 3));
+            uint8_t* destination = this->output.data() + offset;
+            for (uint32_t x = 0; x < width; ++x) {
+                destination[(x * 3) + 0] = pixels[(x * 4) + 0];
+                destination[(x * 3) + 1] = pixels[(x * 4) + 1];
+                destination[(x * 3) + 2] = pixels[(x * 4) + 2];
+            }
+            break;
+        }
+        case ImageFormat::PNG: {
+            // the up filter stores the difference to the row above, rendered images are mostly
+            // smooth vertically so the differences compress well
+            uint8_t* previous = this->previous_row.data();
+            for (size_t i = 0; i < this->row.size(); ++i) {
+                uint8_t value = pixels[i];
+                pixels[i] = static_cast<uint8_t>(value - previous[i]);
+                previous[i] = value;
+            }
+
+            const uint8_t filter = 2;
+            this->deflater.compress(&filter, 1, this->compressed);
+            this->deflater.compress(pixels, this->row.size(), this->compressed);
+            if (this->compressed.size() >= PNG_CHUNK_SIZE) {
+                this->writeChunk("IDAT", this->compressed.data(), this->compressed.size());
+                this->compressed.clear();
+            }
+            break;
+        }
+    }
+
+    if (this->output.size() >= IMAGE_OUTPUT_BLOCK_SIZE) {
+        this->flush();
+    }
+}
+
+void ImageWriter::writeChunk(const char* type, const uint8_t* data, size_t size) {
+    appendBigEndian(this->output, static_cast<uint32_t>(size));
+    size_t start = this->output.size();
+    this->output.insert(this->output.end(), type, type + 4);
+    if (size > 0) {
+        this->output.insert(this->output.end(), data, data + size);
+    }
+    appendBigEndian(this->output, updateCrc(0xFFFFFFFF, this->output.data() + start, size + 4) ^ 0xFFFFFFFF);
+
+    if (this->output.size() >= IMAGE_OUTPUT_BLOCK_SIZE) {
+        this->flush();
+    }
+}
+
+void ImageWriter::flush() {
+    this->file.write(reinterpret_cast<const char*>(this->output.data()), static_cast<std::streamsize>(this->output.size()));
+    if (this->file.fail()) {
+        throw std::runtime_error("Failed to write image");
+    }
+    this->output.clear();
+}
+
+void saveImage(const std::string& path, ColorBuffer* color_buffer, ImageFormat format) {
+    if (!color_buffer) {
+        throw std::invalid_argument("'color_buffer' cannot be nullptr");
+    }
+
+    ImageWriter writer(path, color_buffer->getDimensions(), format);
+    writer.writeRows(color_buffer, color_buffer->getDimensions().y);
+    writer.finish();
+}
+
+} // namespace apparition
@@ -21,6 +21,39 @@
 
 namespace apparition {
 
+void transform(const Matrix4x4f& matrix, const Vector4f* in, Vector4f* out, size_t count) {
+    // transpose once so each vector becomes a weighted sum of the matrix columns
+    Float4 column_0 = Float4::load(matrix[0].getData());
+    Float4 column_1 = Float4::load(matrix[1].getData());
+    Float4 column_2 = Float4::load(matrix[2].getData());
+    Float4 column_3 = Float4::load(matrix[3].getData());
+    transpose4x4(column_0, column_1, column_2, column_3);
 
+    size_t i = 0;
+
+#ifdef APPARITION_AVX
+    // two vectors per iteration, one in each 128-bit lane
+    __m256 wide_column_0 = _mm256_set_m128(column_0.value, column_0.value);
+    __m256 wide_column_1 = _mm256_set_m128(column_1.value, column_1.value);
+    __m256 wide_column_2 = _mm256_set_m128(column_2.value, column_2.value);
+    __m256 wide_column_3 = _mm256_set_m128(column_3.value, column_3.value);
+
+    for (; i + 2 <= count; i += 2) {
+        __m256 vectors = _mm256_loadu_ps(in[i].data);
+        __m256 sum = _mm256_mul_ps(wide_column_0, _mm256_permute_ps(vectors, _MM_SHUFFLE(0, 0, 0, 0)));
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(wide_column_1, _mm256_permute_ps(vectors, _MM_SHUFFLE(1, 1, 1, 1))));
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(wide_column_2, _mm256_permute_ps(vectors, _MM_SHUFFLE(2, 2, 2, 2))));
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(wide_column_3, _mm256_permute_ps(vectors, _MM_SHUFFLE(3, 3, 3, 3))));
+        _mm256_storeu_ps(out[i].data, sum);
+    }
+#endif
+
+    for (; i < count; ++i) {
+        const Vector4f& vector = in[i];
+        Float4 sum = (column_0 * Float4::broadcast(vector.x)) + (column_1 * Float4::broadcast(vector.y));
+        sum = sum + (column_2 * Float4::broadcast(vector.z)) + (column_3 * Float4::broadcast(vector.w));
+        sum.store(out[i].data);
+    }
+}
 
 } // namespace apparition
\ No newline at end of file
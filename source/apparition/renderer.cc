@@ -15,21 +15,33 @@
 // See the License for the specific language governing permissionsand
 // limitations under the License.
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
 #include "renderer.hh"
+#include "command_buffer.hh"
 #include "shader.hh"
 
 namespace apparition {
 
-FrameBuffer::FrameBuffer(Vector2u dimensions) {
+FrameBuffer::FrameBuffer(Vector2u dimensions, BufferLayout layout, ColorFormat color_format, DepthFormat depth_format, uint32_t sample_count) {
+    getSamplePositions(sample_count);
     this->dimensions = dimensions;
+    this->sample_count = sample_count;
 
-    this->color_buffer = new ColorBuffer(dimensions);
-    this->depth_buffer = new DepthBuffer(dimensions);
+    this->color_buffer = new ColorBuffer(dimensions, layout, color_format, sample_count);
+    this->depth_buffer = new DepthBuffer(dimensions, layout, depth_format, sample_count);
+    this->primitive_buffer = new PrimitiveBuffer(dimensions, layout, sample_count);
+    this->primitive_buffer->fill(0);
 }
 
 FrameBuffer::~FrameBuffer() {
     delete this->color_buffer;
     delete this->depth_buffer;
+    delete this->primitive_buffer;
 }
 
 ColorBuffer* FrameBuffer::getColorBuffer() {
@@ -40,265 +52,2363 @@ DepthBuffer* FrameBuffer::getDepthBuffer() {
     return this->depth_buffer;
 }
 
+PrimitiveBuffer* FrameBuffer::getPrimitiveBuffer() {
+    return this->primitive_buffer;
+}
+
 Vector2u FrameBuffer::getDimensions() {
     return this->dimensions;
 }
 
-Renderer::Renderer() {
-    this->frame_buffer = nullptr;
-    this->vertex_buffer = nullptr;
-    this->index_buffer = nullptr;
-    this->shader = nullptr;
+uint32_t FrameBuffer::getSampleCount() {
+    return this->sample_count;
 }
 
-void Renderer::bindFrameBuffer(FrameBuffer* to_bind) {
-    if (!to_bind) {
-        throw std::invalid_argument("'to_bind' cannot be nullptr");
+void FrameBuffer::clear(Vector4f color, float depth) {
+    this->color_buffer->clear(color);
+    this->depth_buffer->clear(depth);
+}
+
+uint32_t getColorFormatSize(ColorFormat format) {
+    switch (format) {
+        case ColorFormat::RGBA32F:
+            return 16;
+        case ColorFormat::RGBA16F:
+            return 8;
+        case ColorFormat::RGB10A2_UNORM:
+        case ColorFormat::RGBA8_UNORM:
+            return 4;
     }
 
-    this->frame_buffer = to_bind;
+    throw std::invalid_argument("'format' is not a color format");
 }
 
-void Renderer::bindVertexBuffer(std::vector<Vertex>* to_bind) {
-    if (!to_bind) {
-        throw std::invalid_argument("'to_bind' cannot be nullptr");
+uint32_t getDepthFormatSize(DepthFormat format) {
+    switch (format) {
+        case DepthFormat::D32F:
+        case DepthFormat::D24S8:
+            return 4;
+        case DepthFormat::D16:
+            return 2;
     }
 
-    this->vertex_buffer = to_bind;
+    throw std::invalid_argument("'format' is not a depth format");
 }
 
-void Renderer::bindIndexBuffer(std::vector<size_t>* to_bind) {
-    if (!to_bind) {
-        throw std::invalid_argument("'to_bind' cannot be nullptr");
+const SamplePosition* getSamplePositions(uint32_t sample_count) {
+    static const SamplePosition PATTERN_1[1] = {{0, 0}};
+    static const SamplePosition PATTERN_2[2] = {{4, 4}, {-4, -4}};
+    static const SamplePosition PATTERN_4[4] = {{-2, -6}, {6, -2}, {-6, 2}, {2, 6}};
+    static const SamplePosition PATTERN_8[8] = {{1, -3}, {-1, 3}, {5, 1}, {-3, -5}, {-5, 5}, {-7, -1}, {3, 7}, {7, -7}};
+    switch (sample_count) {
+        case 1:
+            return PATTERN_1;
+        case 2:
+            return PATTERN_2;
+        case 4:
+            return PATTERN_4;
+        case 8:
+            return PATTERN_8;
     }
 
-    this->index_buffer = to_bind;
+    throw std::invalid_argument("'sample_count' must be 1, 2, 4 or 8");
 }
 
-void Renderer::bindShader(Shader* to_bind) {
-    if (!to_bind) {
-        throw std::invalid_argument("'to_bind' cannot be nullptr");
+// rounds to the nearest step, nan is stored as zero, double keeps all 24 bits of D24S8 exact
+static uint32_t packUnorm(float value, uint32_t max) {
+    double clamped = value > 0.0f ? std::min(value, 1.0f) : 0.0f;
+    return static_cast<uint32_t>((clamped * max) + 0.5);
+}
+
+static float unpackUnorm(uint32_t value, uint32_t max) {
+    return static_cast<float>(value) / static_cast<float>(max);
+}
+
+// round to nearest even, values past the largest half become infinity
+static uint16_t packHalf(float value) {
+    uint32_t bits = std::bit_cast<uint32_t>(value);
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t magnitude = bits & 0x7FFFFFFF;
+
+    if (magnitude >= 0x7F800000) {
+        return static_cast<uint16_t>(sign | 0x7C00 | (magnitude > 0x7F800000 ? 0x200 : 0));
+    }
+    if (magnitude >= 0x477FF000) {
+        return static_cast<uint16_t>(sign | 0x7C00);
+    }
+    if (magnitude < 0x38800000) {
+        // adding 0.5 lines the float mantissa up with the half subnormal steps
+        float subnormal = std::bit_cast<float>(magnitude) + 0.5f;
+        return static_cast<uint16_t>(sign | (std::bit_cast<uint32_t>(subnormal) - 0x3F000000));
     }
 
-    this->shader = to_bind;
+    // rebias the exponent and round off the low 13 mantissa bits
+    magnitude += 0xC8000FFF + ((magnitude >> 13) & 1);
+    return static_cast<uint16_t>(sign | (magnitude >> 13));
 }
 
-void Renderer::drawLines() {
-    if (!this->frame_buffer) {
-        throw std::logic_error("No frame buffer bound");
+static float unpackHalf(uint16_t value) {
+    uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1F;
+    uint32_t mantissa = value & 0x3FF;
+
+    if (exponent == 0x1F) {
+        return std::bit_cast<float>(sign | 0x7F800000 | (mantissa << 13));
     }
-    if (!this->vertex_buffer) {
-        throw std::logic_error("No vertex buffer bound");
+    if (exponent == 0) {
+        float subnormal = static_cast<float>(mantissa) * (1.0f / 16777216.0f);
+        return std::bit_cast<float>(sign | std::bit_cast<uint32_t>(subnormal));
     }
-    if (!this->index_buffer) {
-        throw std::logic_error("No index buffer bound");
+
+    return std::bit_cast<float>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+template<ColorFormat F>
+static void packColor(uint8_t* pixel, const Vector4f& color) {
+    if constexpr (F == ColorFormat::RGBA32F) {
+        std::memcpy(pixel, color.data, 16);
+    } else if constexpr (F == ColorFormat::RGBA16F) {
+        uint16_t halves[4] = {packHalf(color.r), packHalf(color.g), packHalf(color.b), packHalf(color.a)};
+        std::memcpy(pixel, halves, 8);
+    } else if constexpr (F == ColorFormat::RGB10A2_UNORM) {
+        uint32_t packed = packUnorm(color.r, 1023) | (packUnorm(color.g, 1023) << 10) | (packUnorm(color.b, 1023) << 20) | (packUnorm(color.a, 3) << 30);
+        std::memcpy(pixel, &packed, 4);
+    } else {
+        uint32_t packed = packUnorm(color.r, 255) | (packUnorm(color.g, 255) << 8) | (packUnorm(color.b, 255) << 16) | (packUnorm(color.a, 255) << 24);
+        std::memcpy(pixel, &packed, 4);
     }
-    if (!this->shader) {
-        throw std::logic_error("No shader bound");
+}
+
+template<ColorFormat F>
+static Vector4f unpackColor(const uint8_t* pixel) {
+    Vector4f color;
+    if constexpr (F == ColorFormat::RGBA32F) {
+        std::memcpy(color.data, pixel, 16);
+    } else if constexpr (F == ColorFormat::RGBA16F) {
+        uint16_t halves[4];
+        std::memcpy(halves, pixel, 8);
+        color = Vector4f(unpackHalf(halves[0]), unpackHalf(halves[1]), unpackHalf(halves[2]), unpackHalf(halves[3]));
+    } else if constexpr (F == ColorFormat::RGB10A2_UNORM) {
+        uint32_t packed;
+        std::memcpy(&packed, pixel, 4);
+        color = Vector4f(unpackUnorm(packed & 0x3FF, 1023), unpackUnorm((packed >> 10) & 0x3FF, 1023), unpackUnorm((packed >> 20) & 0x3FF, 1023), unpackUnorm(packed >> 30, 3));
+    } else {
+        uint32_t packed;
+        std::memcpy(&packed, pixel, 4);
+        color = Vector4f(unpackUnorm(packed & 0xFF, 255), unpackUnorm((packed >> 8) & 0xFF, 255), unpackUnorm((packed >> 16) & 0xFF, 255), unpackUnorm(packed >> 24, 255));
     }
 
-    if (this->index_buffer->size() % 2 != 0) {
-        throw std::invalid_argument("Index buffer size must be divisible by 2");
+    return color;
+}
+
+static void packColor(ColorFormat format, uint8_t* pixel, const Vector4f& color) {
+    switch (format) {
+        case ColorFormat::RGBA32F:
+            packColor<ColorFormat::RGBA32F>(pixel, color);
+            break;
+        case ColorFormat::RGBA16F:
+            packColor<ColorFormat::RGBA16F>(pixel, color);
+            break;
+        case ColorFormat::RGB10A2_UNORM:
+            packColor<ColorFormat::RGB10A2_UNORM>(pixel, color);
+            break;
+        case ColorFormat::RGBA8_UNORM:
+            packColor<ColorFormat::RGBA8_UNORM>(pixel, color);
+            break;
     }
+}
 
-    Vector2u dimensions = this->frame_buffer->getDimensions();
+static Vector4f unpackColor(ColorFormat format, const uint8_t* pixel) {
+    switch (format) {
+        case ColorFormat::RGBA32F:
+            return unpackColor<ColorFormat::RGBA32F>(pixel);
+        case ColorFormat::RGBA16F:
+            return unpackColor<ColorFormat::RGBA16F>(pixel);
+        case ColorFormat::RGB10A2_UNORM:
+            return unpackColor<ColorFormat::RGB10A2_UNORM>(pixel);
+        case ColorFormat::RGBA8_UNORM:
+            return unpackColor<ColorFormat::RGBA8_UNORM>(pixel);
+    }
 
-    std::vector<Line> lines;
-    for (size_t i = 0; i < this->index_buffer->size(); i += 2) {
-        size_t index_0 = this->index_buffer->at(i);
-        size_t index_1 = this->index_buffer->at(i + 1);
+    return Vector4f();
+}
+
+// writes every sample set in the sample mask of a lane, samples of a pixel are size bytes apart
+template<ColorFormat F>
+static void packQuad(uint8_t* data, uint32_t stride, uint32_t size, const uint32_t indices[4], const uint32_t sample_masks[4], const Vector4f colors[4]) {
+    for (uint32_t lane = 0; lane < 4; ++lane) {
+        uint8_t* pixel = data + (static_cast<size_t>(indices[lane]) * stride);
+        for (uint32_t samples = sample_masks[lane]; samples; samples &= samples - 1) {
+            packColor<F>(pixel + (std::countr_zero(samples) * size), colors[lane]);
+        }
+    }
+}
+
+// lerps the masked samples from the stored color towards the new one by the coverage of their lane
+template<ColorFormat F>
+static void blendQuad(uint8_t* data, uint32_t stride, uint32_t size, const uint32_t indices[4], const uint32_t sample_masks[4], const Vector4f colors[4], const float coverage[4]) {
+    for (uint32_t lane = 0; lane < 4; ++lane) {
+        uint8_t* pixel = data + (static_cast<size_t>(indices[lane]) * stride);
+        Float4 source = Float4::load(colors[lane].data);
+        Float4 weight = Float4::broadcast(coverage[lane]);
+        for (uint32_t samples = sample_masks[lane]; samples; samples &= samples - 1) {
+            uint8_t* sample = pixel + (std::countr_zero(samples) * size);
+            Float4 destination = Float4::load(unpackColor<F>(sample).data);
 
-        if (index_0 < 0 || index_0 >= this->vertex_buffer->size() || index_1 < 0 || index_1 >= this->vertex_buffer->size()) {
-            throw std::out_of_range("Index out of range");
+            Vector4f blended;
+            (destination + ((source - destination) * weight)).store(blended.data);
+            packColor<F>(sample, blended);
         }
+    }
+}
+
+ColorBuffer::ColorBuffer(Vector2u dimensions, BufferLayout layout, ColorFormat format, uint32_t sample_count) : BaseBuffer2D(dimensions, layout, getColorFormatSize(format) * sample_count) {
+    getSamplePositions(sample_count);
+    this->format = format;
+    this->sample_count = sample_count;
+    this->clear(Vector4f(0.0f, 0.0f, 0.0f, 0.0f));
+}
 
-        Vertex vertex_0 = this->vertex_buffer->at(index_0);
-        Vertex vertex_1 = this->vertex_buffer->at(index_1);
+ColorFormat ColorBuffer::getFormat() {
+    return this->format;
+}
+
+uint32_t ColorBuffer::getSampleCount() {
+    return this->sample_count;
+}
 
-        this->runVertexShader(vertex_0);
-        this->runVertexShader(vertex_1);
+Vector4f ColorBuffer::get(Vector2u position) {
+    if (position.x >= this->dimensions.x || position.y >= this->dimensions.y) {
+        throw std::out_of_range("'position' is out of range");
+    }
 
-        Line line(vertex_0, vertex_1);
+    this->resolve(position.x, position.y, position.x, position.y);
+    return this->load(this->getIndex(position));
+}
 
-        lines.push_back(line);
+void ColorBuffer::set(Vector2u position, Vector4f color) {
+    if (position.x >= this->dimensions.x || position.y >= this->dimensions.y) {
+        throw std::out_of_range("'position' is out of range");
     }
 
-    for (Line& line : lines) {
-        // draw line using bresenham's algorithm
-        // based on pseudocode stolen from wikipedia
+    this->resolve(position.x, position.y, position.x, position.y);
+    this->store(this->getIndex(position), color);
+}
 
-        int original_x0 = line.vertex_0.position.x * (dimensions.x - 1);
-        int original_x1 = line.vertex_1.position.x * (dimensions.x - 1);
-        int original_y0 = line.vertex_0.position.y * (dimensions.y - 1);
-        int original_y1 = line.vertex_1.position.y * (dimensions.y - 1);
+// buffers read from several threads, like texture levels, are filled right away
+void ColorBuffer::fill(Vector4f color) {
+    this->clear(color);
+    this->getData();
+}
 
-        int x0 = original_x0;
-        int x1 = original_x1;
-        int y0 = original_y0;
-        int y1 = original_y1;
+// the color is packed once into every sample and written block by block as the blocks are first touched
+void ColorBuffer::clear(Vector4f color) {
+    std::vector<uint8_t> packed(this->stride);
+    uint32_t size = this->stride / this->sample_count;
+    for (uint32_t sample = 0; sample < this->sample_count; ++sample) {
+        packColor(this->format, packed.data() + (sample * size), color);
+    }
+    this->fillDeferred(packed.data());
+}
 
-        int dx = std::abs(x1 - x0);
-        int sx = x0 < x1 ? 1 : -1;
-        int dy = -std::abs(y1 - y0);
-        int sy = y0 < y1 ? 1 : -1;
-        int error = dx + dy;
+// destination has to hold width * height colors, samples are averaged
+void ColorBuffer::copyToLinear(Vector4f* destination) {
+    if (!destination) {
+        throw std::invalid_argument("'destination' cannot be nullptr");
+    }
 
-        float total_distance = std::sqrt((x1 - x0) * (x1 - x0) + (y1 - y0) * (y1 - y0));
+    this->getData();
+    for (uint32_t y = 0; y < this->dimensions.y; ++y) {
+        for (uint32_t x = 0; x < this->dimensions.x; ++x) {
+            *destination++ = this->load(this->getIndex(Vector2u(x, y)));
+        }
+    }
+}
 
-        for (;;) {
-            Fragment& fragment = this->frame_buffer->getDepthBuffer()->get(Vector2u(x0, y0));
-            fragment.primitive = static_cast<Primitive*>(&line);
+// source has to hold width * height colors in row-major order, every sample of a pixel is set
+void ColorBuffer::copyFromLinear(const Vector4f* source) {
+    if (!source) {
+        throw std::invalid_argument("'source' cannot be nullptr");
+    }
 
-            float current_distance = std::sqrt((x0 - original_x0) * (x0 - original_x0) + (y0 - original_y0) * (y0 - original_y0));
-            fragment.t = current_distance / total_distance;
+    this->getData();
+    for (uint32_t y = 0; y < this->dimensions.y; ++y) {
+        for (uint32_t x = 0; x < this->dimensions.x; ++x) {
+            this->store(this->getIndex(Vector2u(x, y)), *source++);
+        }
+    }
+}
 
-            if (x0 == x1 && y0 == y1) {
-                break;
-            }
+// averages the samples of every pixel into a buffer of the same dimensions, the destination
+// can have any layout, format and sample count
+void ColorBuffer::resolveSamples(ColorBuffer* destination) {
+    if (!destination) {
+        throw std::invalid_argument("'destination' cannot be nullptr");
+    }
 
-            int e2 = 2 * error;
-            if (e2 >= dy) {
-                error += dy;
-                x0 += sx;
-            }
-            
-            if (e2 <= dx) {
-                error += dx;
-                y0 += sy;
-            }
+    Vector2u destination_dimensions = destination->getDimensions();
+    if (destination_dimensions.x != this->dimensions.x || destination_dimensions.y != this->dimensions.y) {
+        throw std::invalid_argument("'destination' has to match the dimensions of the buffer");
+    }
+
+    if (destination == this) {
+        return;
+    }
+
+    this->getData();
+    destination->getData();
+    for (uint32_t y = 0; y < this->dimensions.y; ++y) {
+        for (uint32_t x = 0; x < this->dimensions.x; ++x) {
+            destination->store(destination->getIndex(Vector2u(x, y)), this->load(this->getIndex(Vector2u(x, y))));
         }
     }
+}
+
+// reads the average of the samples of a pixel
+Vector4f ColorBuffer::load(size_t index) {
+    const uint8_t* pixel = this->data + (index * this->stride);
+    if (this->sample_count == 1) {
+        return unpackColor(this->format, pixel);
+    }
+
+    uint32_t size = this->stride / this->sample_count;
+    Float4 sum = Float4::broadcast(0.0f);
+    for (uint32_t sample = 0; sample < this->sample_count; ++sample) {
+        sum = sum + Float4::load(unpackColor(this->format, pixel + (sample * size)).data);
+    }
+
+    Vector4f color;
+    (sum * Float4::broadcast(1.0f / static_cast<float>(this->sample_count))).store(color.data);
+    return color;
+}
+
+// writes every sample of a pixel
+void ColorBuffer::store(size_t index, Vector4f color) {
+    uint8_t* pixel = this->data + (index * this->stride);
+    uint32_t size = this->stride / this->sample_count;
+    for (uint32_t sample = 0; sample < this->sample_count; ++sample) {
+        packColor(this->format, pixel + (sample * size), color);
+    }
+}
+
+// writes the samples set in the mask of each lane, the format is dispatched once per quad rather than per pixel
+void ColorBuffer::storeQuad(const uint32_t indices[4], const uint32_t sample_masks[4], const Vector4f colors[4]) {
+    uint32_t size = this->stride / this->sample_count;
+    switch (this->format) {
+        case ColorFormat::RGBA32F:
+            packQuad<ColorFormat::RGBA32F>(this->data, this->stride, size, indices, sample_masks, colors);
+            break;
+        case ColorFormat::RGBA16F:
+            packQuad<ColorFormat::RGBA16F>(this->data, this->stride, size, indices, sample_masks, colors);
+            break;
+        case ColorFormat::RGB10A2_UNORM:
+            packQuad<ColorFormat::RGB10A2_UNORM>(this->data, this->stride, size, indices, sample_masks, colors);
+            break;
+        case ColorFormat::RGBA8_UNORM:
+            packQuad<ColorFormat::RGBA8_UNORM>(this->data, this->stride, size, indices, sample_masks, colors);
+            break;
+    }
+}
 
-    for (size_t i = 0; i < dimensions.x; ++i) {
-        for (size_t j = 0; j < dimensions.y; ++j) {
-            Vector2u fragment_position = Vector2u(i, j);
-            Fragment& fragment = this->frame_buffer->getDepthBuffer()->get(fragment_position);
+void ColorBuffer::blendQuad(const uint32_t indices[4], const uint32_t sample_masks[4], const Vector4f colors[4], const float coverage[4]) {
+    uint32_t size = this->stride / this->sample_count;
+    switch (this->format) {
+        case ColorFormat::RGBA32F:
+            apparition::blendQuad<ColorFormat::RGBA32F>(this->data, this->stride, size, indices, sample_masks, colors, coverage);
+            break;
+        case ColorFormat::RGBA16F:
+            apparition::blendQuad<ColorFormat::RGBA16F>(this->data, this->stride, size, indices, sample_masks, colors, coverage);
+            break;
+        case ColorFormat::RGB10A2_UNORM:
+            apparition::blendQuad<ColorFormat::RGB10A2_UNORM>(this->data, this->stride, size, indices, sample_masks, colors, coverage);
+            break;
+        case ColorFormat::RGBA8_UNORM:
+            apparition::blendQuad<ColorFormat::RGBA8_UNORM>(this->data, this->stride, size, indices, sample_masks, colors, coverage);
+            break;
+    }
+}
 
-            this->runFragmentShader(fragment_position, fragment);
-            this->frame_buffer->getColorBuffer()->set(fragment_position, this->shader->out_fragment_color);
+static float unpackDepth(DepthFormat format, const uint8_t* pixel) {
+    switch (format) {
+        case DepthFormat::D32F: {
+            float depth;
+            std::memcpy(&depth, pixel, 4);
+            return depth;
+        }
+        case DepthFormat::D24S8: {
+            uint32_t packed;
+            std::memcpy(&packed, pixel, 4);
+            return unpackUnorm(packed & 0xFFFFFF, 0xFFFFFF);
+        }
+        case DepthFormat::D16: {
+            uint16_t packed;
+            std::memcpy(&packed, pixel, 2);
+            return unpackUnorm(packed, 0xFFFF);
         }
     }
+
+    return 0.0f;
 }
 
-void Renderer::drawTris() {
-    if (!this->frame_buffer) {
-        throw std::logic_error("No frame buffer bound");
+DepthBuffer::DepthBuffer(Vector2u dimensions, BufferLayout layout, DepthFormat format, uint32_t sample_count) : BaseBuffer2D(dimensions, layout, getDepthFormatSize(format) * sample_count) {
+    getSamplePositions(sample_count);
+    this->format = format;
+    this->sample_count = sample_count;
+    this->bounds.resize(static_cast<size_t>(this->block_columns) * this->block_rows);
+    this->stale.resize(this->bounds.size());
+    this->clear(1.0f);
+}
+
+DepthFormat DepthBuffer::getFormat() {
+    return this->format;
+}
+
+uint32_t DepthBuffer::getSampleCount() {
+    return this->sample_count;
+}
+
+float DepthBuffer::get(Vector2u position) {
+    if (position.x >= this->dimensions.x || position.y >= this->dimensions.y) {
+        throw std::out_of_range("'position' is out of range");
     }
-    if (!this->vertex_buffer) {
-        throw std::logic_error("No vertex buffer bound");
+
+    this->resolve(position.x, position.y, position.x, position.y);
+    return this->load(this->getIndex(position), 0);
+}
+
+void DepthBuffer::set(Vector2u position, float depth) {
+    if (position.x >= this->dimensions.x || position.y >= this->dimensions.y) {
+        throw std::out_of_range("'position' is out of range");
     }
-    if (!this->index_buffer) {
-        throw std::logic_error("No index buffer bound");
+
+    this->resolve(position.x, position.y, position.x, position.y);
+    size_t index = this->getIndex(position);
+    for (uint32_t sample = 0; sample < this->sample_count; ++sample) {
+        this->test(index, sample, DepthFunction::ALWAYS, depth, true);
     }
-    if (!this->shader) {
-        throw std::logic_error("No shader bound");
+    this->invalidateBounds(position.x, position.y, position.x, position.y);
+}
+
+void DepthBuffer::clear(float depth) {
+    std::vector<uint8_t> packed(this->stride);
+    switch (this->format) {
+        case DepthFormat::D32F:
+            std::memcpy(packed.data(), &depth, 4);
+            break;
+        case DepthFormat::D24S8: {
+            uint32_t quantized = packUnorm(depth, 0xFFFFFF);
+            std::memcpy(packed.data(), &quantized, 4);
+            break;
+        }
+        case DepthFormat::D16: {
+            uint16_t quantized = static_cast<uint16_t>(packUnorm(depth, 0xFFFF));
+            std::memcpy(packed.data(), &quantized, 2);
+            break;
+        }
     }
 
-    if (this->index_buffer->size() % 3 != 0) {
-        throw std::invalid_argument("Index buffer size must be divisible by 3");
+    uint32_t size = this->stride / this->sample_count;
+    for (uint32_t sample = 1; sample < this->sample_count; ++sample) {
+        std::copy(packed.begin(), packed.begin() + size, packed.begin() + (sample * size));
     }
 
-    Vector2u dimensions = this->frame_buffer->getDimensions();
+    // blocks are written as they are first touched, until then they hold the cleared value
+    // exactly so the bounds are known without a scan
+    this->fillDeferred(packed.data());
+    float cleared = unpackDepth(this->format, packed.data());
+    std::fill(this->bounds.begin(), this->bounds.end(), DepthBounds{cleared, cleared});
+    std::fill(this->stale.begin(), this->stale.end(), 0);
+}
 
-    std::vector<Tri> tris;
-    for (size_t i = 0; i < this->index_buffer->size(); i += 3) {
-        size_t index_0 = this->index_buffer->at(i);
-        size_t index_1 = this->index_buffer->at(i + 1);
-        size_t index_2 = this->index_buffer->at(i + 2);
-
-        if (index_0 < 0 || index_0 >= this->vertex_buffer->size() || index_1 < 0 || index_1 >= this->vertex_buffer->size() || index_2 < 0 || index_2 >= this->vertex_buffer->size()) {
-            throw std::out_of_range("Index out of range");
-        }
-
-        Vertex vertex_0 = this->vertex_buffer->at(index_0);
-        Vertex vertex_1 = this->vertex_buffer->at(index_1);
-        Vertex vertex_2 = this->vertex_buffer->at(index_2);
-
-        this->runVertexShader(vertex_0);
-        this->runVertexShader(vertex_1);
-        this->runVertexShader(vertex_2);
-
-        Tri tri(vertex_0, vertex_1, vertex_2);
-
-        tris.push_back(tri);
-    }
-
-    for (Tri& tri : tris) {
-        // draw tri using barycentric algorithm
-        
-        float x0 = tri.vertex_0.position.x * (dimensions.x - 1);
-        float x1 = tri.vertex_1.position.x * (dimensions.x - 1);
-        float x2 = tri.vertex_2.position.x * (dimensions.x - 1);
-        float y0 = tri.vertex_0.position.y * (dimensions.y - 1);
-        float y1 = tri.vertex_1.position.y * (dimensions.y - 1);
-        float y2 = tri.vertex_2.position.y * (dimensions.y - 1);
-
-        float denominator = ((y1 - y2) * (x0 - x2)) + ((x2 - x1) * (y0 - y2));
-        
-        for (uint32_t x = 0; x < dimensions.x; ++x) {
-            for (uint32_t y = 0; y < dimensions.y; ++y) {
-                float b0 = (((y1 - y2) * (x - x2)) + ((x2 - x1) * (y - y2))) / denominator;
-                float b1 = (((y2 - y0) * (x - x2)) + ((x0 - x2) * (y - y2))) / denominator;
-                float b2 = 1 - b0 - b1;
-
-                if (b0 >= 0.0f && b0 <= 1.0f && b1 >= 0.0f && b1 <= 1.0f && b2 >= 0.0f && b2 <= 1.0f) {
-                    Fragment& fragment = this->frame_buffer->getDepthBuffer()->get(Vector2u(x, y));
-                    fragment.primitive = static_cast<Primitive*>(&tri);
-                    fragment.b0 = b0;
-                    fragment.b1 = b1;
-                    fragment.b2 = b2;
+// bounds of the pixels in the rectangle, rounded out to whole blocks, which are rescanned if a
+// write made them stale, blocks are only ever refreshed by the worker owning their tile
+DepthBounds DepthBuffer::getBounds(uint32_t min_x, uint32_t min_y, uint32_t max_x, uint32_t max_y) {
+    DepthBounds result{INFINITY, -INFINITY};
+    for (uint32_t block_y = min_y / BUFFER_BLOCK_SIZE; block_y <= max_y / BUFFER_BLOCK_SIZE; ++block_y) {
+        for (uint32_t block_x = min_x / BUFFER_BLOCK_SIZE; block_x <= max_x / BUFFER_BLOCK_SIZE; ++block_x) {
+            // blocks still waiting on a clear were never written and keep the bounds of the clear
+            size_t block = (static_cast<size_t>(block_y) * this->block_columns) + block_x;
+            if (this->stale[block] && this->pending[block]) {
+                this->stale[block] = 0;
+            } else if (this->stale[block]) {
+                DepthBounds refreshed{INFINITY, -INFINITY};
+                uint32_t end_x = std::min((block_x + 1) * BUFFER_BLOCK_SIZE, this->dimensions.x);
+                uint32_t end_y = std::min((block_y + 1) * BUFFER_BLOCK_SIZE, this->dimensions.y);
+                // single sampled buffers skip the sample loop, the rescan is the hot path of the depth bounds
+                if (this->sample_count == 1) {
+                    for (uint32_t y = block_y * BUFFER_BLOCK_SIZE; y < end_y; ++y) {
+                        for (uint32_t x = block_x * BUFFER_BLOCK_SIZE; x < end_x; ++x) {
+                            float depth = this->load(this->getIndex(Vector2u(x, y)), 0);
+                            refreshed.min = std::min(refreshed.min, depth);
+                            refreshed.max = std::max(refreshed.max, depth);
+                        }
+                    }
+                } else {
+                    for (uint32_t y = block_y * BUFFER_BLOCK_SIZE; y < end_y; ++y) {
+                        for (uint32_t x = block_x * BUFFER_BLOCK_SIZE; x < end_x; ++x) {
+                            size_t index = this->getIndex(Vector2u(x, y));
+                            for (uint32_t sample = 0; sample < this->sample_count; ++sample) {
+                                float depth = this->load(index, sample);
+                                refreshed.min = std::min(refreshed.min, depth);
+                                refreshed.max = std::max(refreshed.max, depth);
+                            }
+                        }
+                    }
                 }
+
+                this->bounds[block] = refreshed;
+                this->stale[block] = 0;
             }
+
+            result.min = std::min(result.min, this->bounds[block].min);
+            result.max = std::max(result.max, this->bounds[block].max);
         }
     }
 
-    for (size_t i = 0; i < dimensions.x; ++i) {
-        for (size_t j = 0; j < dimensions.y; ++j) {
-            Vector2u fragment_position = Vector2u(i, j);
-            Fragment& fragment = this->frame_buffer->getDepthBuffer()->get(fragment_position);
+    return result;
+}
+
+void DepthBuffer::invalidateBounds(uint32_t min_x, uint32_t min_y, uint32_t max_x, uint32_t max_y) {
+    for (uint32_t block_y = min_y / BUFFER_BLOCK_SIZE; block_y <= max_y / BUFFER_BLOCK_SIZE; ++block_y) {
+        size_t row = static_cast<size_t>(block_y) * this->block_columns;
+        std::fill(this->stale.begin() + row + (min_x / BUFFER_BLOCK_SIZE), this->stale.begin() + row + (max_x / BUFFER_BLOCK_SIZE) + 1, 1);
+    }
+}
 
-            this->runFragmentShader(fragment_position, fragment);
-            this->frame_buffer->getColorBuffer()->set(fragment_position, this->shader->out_fragment_color);
+// widens the bounds of the blocks in the rectangle to include depths, cheaper than a rescan for
+// writes touching few pixels of each block, like lines, at the price of looser bounds
+void DepthBuffer::expandBounds(uint32_t min_x, uint32_t min_y, uint32_t max_x, uint32_t max_y, DepthBounds depths) {
+    for (uint32_t block_y = min_y / BUFFER_BLOCK_SIZE; block_y <= max_y / BUFFER_BLOCK_SIZE; ++block_y) {
+        for (uint32_t block_x = min_x / BUFFER_BLOCK_SIZE; block_x <= max_x / BUFFER_BLOCK_SIZE; ++block_x) {
+            size_t block = (static_cast<size_t>(block_y) * this->block_columns) + block_x;
+            this->bounds[block].min = std::min(this->bounds[block].min, depths.min);
+            this->bounds[block].max = std::max(this->bounds[block].max, depths.max);
         }
     }
 }
 
-void Renderer::runVertexShader(Vertex& in_vertex) {
-    if (!this->shader) {
-        throw std::logic_error("No shader bound");
+// one quantization step of the format plus room for the rounding of interpolated depth
+float DepthBuffer::getBoundsEpsilon() {
+    constexpr float INTERPOLATION_EPSILON = 1.0f / (1 << 18);
+    switch (this->format) {
+        case DepthFormat::D32F:
+            return INTERPOLATION_EPSILON;
+        case DepthFormat::D24S8:
+            return INTERPOLATION_EPSILON + (1.0f / 0xFFFFFF);
+        case DepthFormat::D16:
+            return INTERPOLATION_EPSILON + (1.0f / 0xFFFF);
     }
 
-    this->shader->vertex = &in_vertex;
-    this->shader->runVertex();
+    return INTERPOLATION_EPSILON;
 }
 
-void Renderer::runFragmentShader(Vector2u in_fragment_position, Fragment in_fragment) {
-    if (!this->shader) {
-        throw std::logic_error("No shader bound");
+float DepthBuffer::load(size_t index, uint32_t sample) {
+    return unpackDepth(this->format, this->data + (index * this->stride) + (sample * getDepthFormatSize(this->format)));
+}
+
+// unorm formats compare the quantized depth so that a passing test always agrees with the stored value
+bool DepthBuffer::test(size_t index, uint32_t sample, DepthFunction function, float depth, bool write) {
+    uint8_t* pixel = this->data + (index * this->stride);
+    switch (this->format) {
+        case DepthFormat::D32F: {
+            pixel += sample * 4;
+            float stored;
+            std::memcpy(&stored, pixel, 4);
+            if (!testDepth(function, depth, stored)) {
+                return false;
+            }
+            if (write) {
+                std::memcpy(pixel, &depth, 4);
+            }
+            return true;
+        }
+        case DepthFormat::D24S8: {
+            pixel += sample * 4;
+            uint32_t stored;
+            std::memcpy(&stored, pixel, 4);
+            uint32_t quantized = packUnorm(depth, 0xFFFFFF);
+            if (!testDepth(function, quantized, stored & 0xFFFFFF)) {
+                return false;
+            }
+            if (write) {
+                stored = (stored & 0xFF000000) | quantized;
+                std::memcpy(pixel, &stored, 4);
+            }
+            return true;
+        }
+        case DepthFormat::D16: {
+            pixel += sample * 2;
+            uint16_t stored;
+            std::memcpy(&stored, pixel, 2);
+            uint16_t quantized = static_cast<uint16_t>(packUnorm(depth, 0xFFFF));
+            if (!testDepth(function, quantized, stored)) {
+                return false;
+            }
+            if (write) {
+                std::memcpy(pixel, &quantized, 2);
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+uint32_t getMipLevelCount(Vector2u dimensions) {
+    return static_cast<uint32_t>(std::bit_width(std::max(dimensions.x, dimensions.y)));
+}
+
+Texture2D::Texture2D(Vector2u dimensions, ColorFormat format, uint32_t level_count) {
+    if (dimensions.x == 0 || dimensions.y == 0) {
+        throw std::invalid_argument("'dimensions' cannot be zero");
+    }
+
+    if (level_count == 0 || level_count > getMipLevelCount(dimensions)) {
+        throw std::invalid_argument("'level_count' must be between 1 and the length of a full mip chain");
+    }
+
+    this->dimensions = dimensions;
+    this->format = format;
+    for (uint32_t level = 0; level < level_count; ++level) {
+        Vector2u level_dimensions(std::max(dimensions.x >> level, 1u), std::max(dimensions.y >> level, 1u));
+        this->levels.push_back(new ColorBuffer(level_dimensions, BufferLayout::TILED, format));
+
+        // the deferred clear of a new buffer is written out now so lookups only ever read the levels
+        this->levels.back()->getData();
     }
+}
+
+Texture2D::~Texture2D() {
+    for (ColorBuffer* level : this->levels) {
+        delete level;
+    }
+}
+
+Vector2u Texture2D::getDimensions() {
+    return this->dimensions;
+}
+
+ColorFormat Texture2D::getFormat() {
+    return this->format;
+}
+
+uint32_t Texture2D::getLevelCount() {
+    return static_cast<uint32_t>(this->levels.size());
+}
+
+ColorBuffer* Texture2D::getLevel(uint32_t level) {
+    if (level >= this->levels.size()) {
+        throw std::out_of_range("'level' is out of range");
+    }
+
+    return this->levels[level];
+}
+
+// box filters every level from the 2x2 texels above it, the last row or column of an odd level
+// is read twice
+void Texture2D::generateMips() {
+    for (size_t level = 1; level < this->levels.size(); ++level) {
+        ColorBuffer* source = this->levels[level - 1];
+        ColorBuffer* destination = this->levels[level];
+        Vector2u source_dimensions = source->getDimensions();
+        Vector2u dimensions = destination->getDimensions();
+        source->getData();
+        destination->getData();
 
-    this->shader->in_fragment_position = in_fragment_position;
-    this->shader->in_fragment_depth = in_fragment.depth;
-    this->shader->out_fragment_color = Vector4f();
-    this->shader->varying_vertex_color = Vector4f();
+        for (uint32_t y = 0; y < dimensions.y; ++y) {
+            uint32_t y0 = std::min(y * 2, source_dimensions.y - 1);
+            uint32_t y1 = std::min((y * 2) + 1, source_dimensions.y - 1);
+            for (uint32_t x = 0; x < dimensions.x; ++x) {
+                uint32_t x0 = std::min(x * 2, source_dimensions.x - 1);
+                uint32_t x1 = std::min((x * 2) + 1, source_dimensions.x - 1);
+                Float4 sum = Float4::load(source->load(source->getIndex(Vector2u(x0, y0))).data) +
+                    Float4::load(source->load(source->getIndex(Vector2u(x1, y0))).data) +
+                    Float4::load(source->load(source->getIndex(Vector2u(x0, y1))).data) +
+                    Float4::load(source->load(source->getIndex(Vector2u(x1, y1))).data);
 
-    if (in_fragment.primitive) {
-        if (in_fragment.primitive->type == PrimitiveType::LINE) {
-            Line* line = static_cast<Line*>(in_fragment.primitive);
-            this->shader->varying_vertex_color.r = std::lerp(line->vertex_0.color.r, line->vertex_1.color.r, in_fragment.t);
-            this->shader->varying_vertex_color.g = std::lerp(line->vertex_0.color.g, line->vertex_1.color.g, in_fragment.t);
-            this->shader->varying_vertex_color.b = std::lerp(line->vertex_0.color.b, line->vertex_1.color.b, in_fragment.t);
-            this->shader->varying_vertex_color.a = std::lerp(line->vertex_0.color.a, line->vertex_1.color.a, in_fragment.t);
-        } else if (in_fragment.primitive->type == PrimitiveType::TRI) {
-            Tri* tri = static_cast<Tri*>(in_fragment.primitive);
-            this->shader->varying_vertex_color.r = (tri->vertex_0.color.r * in_fragment.b0) + (tri->vertex_1.color.r * in_fragment.b1) + (tri->vertex_2.color.r * in_fragment.b2);
-            this->shader->varying_vertex_color.g = (tri->vertex_0.color.g * in_fragment.b0) + (tri->vertex_1.color.g * in_fragment.b1) + (tri->vertex_2.color.g * in_fragment.b2);
-            this->shader->varying_vertex_color.b = (tri->vertex_0.color.b * in_fragment.b0) + (tri->vertex_1.color.b * in_fragment.b1) + (tri->vertex_2.color.b * in_fragment.b2);
-            this->shader->varying_vertex_color.a = (tri->vertex_0.color.a * in_fragment.b0) + (tri->vertex_1.color.a * in_fragment.b1) + (tri->vertex_2.color.a * in_fragment.b2);    
+                Vector4f color;
+                (sum * Float4::broadcast(0.25f)).store(color.data);
+                destination->store(destination->getIndex(Vector2u(x, y)), color);
+            }
         }
     }
+}
+
+// the two texels along one axis a bilinear lookup blends and the weight of the second one,
+// texel centers sit at half-integer coordinates
+struct TexelSpan {
+    uint32_t first;
+    uint32_t second;
+    float weight;
+};
+
+// floats past 2^23 are whole numbers, so nan, infinite and huge coordinates land on the first
+// texel, the texel position is at least -0.5 so truncation only has to correct the first half texel
+static TexelSpan getTexelSpan(float coordinate, uint32_t size, TextureWrap wrap) {
+    TexelSpan span;
+    if (wrap == TextureWrap::REPEAT) {
+        float fraction = std::abs(coordinate) < 8388608.0f ? coordinate - static_cast<float>(static_cast<int32_t>(coordinate)) : 0.0f;
+        fraction += fraction < 0.0f ? 1.0f : 0.0f;
+        float texel = ((fraction < 1.0f ? fraction : 0.0f) * static_cast<float>(size)) - 0.5f;
+        int32_t first = static_cast<int32_t>(texel) - (texel < 0.0f ? 1 : 0);
+        span.weight = texel - static_cast<float>(first);
+        span.first = first < 0 ? size - 1 : static_cast<uint32_t>(first);
+        span.second = span.first + 1 == size ? 0 : span.first + 1;
+    } else {
+        float texel = (coordinate * static_cast<float>(size)) - 0.5f;
+        texel = texel > 0.0f ? std::min(texel, static_cast<float>(size - 1)) : 0.0f;
+        span.first = static_cast<uint32_t>(texel);
+        span.weight = texel - static_cast<float>(span.first);
+        span.second = std::min(span.first + 1, size - 1);
+    }
+
+    return span;
+}
+
+// unorm texels are filtered in the integer steps they are stored in and normalized once per lookup
+template<ColorFormat F>
+static Float4 loadTexel(const uint8_t* texel) {
+    if constexpr (F == ColorFormat::RGB10A2_UNORM) {
+        uint32_t packed;
+        std::memcpy(&packed, texel, 4);
+        return Float4::set(static_cast<float>(packed & 0x3FF), static_cast<float>((packed >> 10) & 0x3FF), static_cast<float>((packed >> 20) & 0x3FF), static_cast<float>(packed >> 30));
+    } else if constexpr (F == ColorFormat::RGBA8_UNORM) {
+        uint32_t packed;
+        std::memcpy(&packed, texel, 4);
+        return Float4::set(static_cast<float>(packed & 0xFF), static_cast<float>((packed >> 8) & 0xFF), static_cast<float>((packed >> 16) & 0xFF), static_cast<float>(packed >> 24));
+    } else {
+        return Float4::load(unpackColor<F>(texel).data);
+    }
+}
+
+template<ColorFormat F>
+static Float4 normalizeTexel(Float4 texel) {
+    if constexpr (F == ColorFormat::RGB10A2_UNORM) {
+        return texel / Float4::set(1023.0f, 1023.0f, 1023.0f, 3.0f);
+    } else if constexpr (F == ColorFormat::RGBA8_UNORM) {
+        return texel / Float4::broadcast(255.0f);
+    } else {
+        return texel;
+    }
+}
+
+static Float4 lerp(Float4 from, Float4 to, float weight) {
+    return from + ((to - from) * Float4::broadcast(weight));
+}
+
+// filtered texel of one level in the stored scale of the format
+template<ColorFormat F>
+static Float4 sampleLevel(ColorBuffer* level, TextureFilter filter, TextureWrap wrap, float u, float v) {
+    // levels are resolved when written, every render worker reads them at once
+    const uint8_t* data = level->getRawData();
+    uint32_t stride = level->getStride();
+    Vector2u dimensions = level->getDimensions();
+    TexelSpan x = getTexelSpan(u, dimensions.x, wrap);
+    TexelSpan y = getTexelSpan(v, dimensions.y, wrap);
+    if (filter == TextureFilter::NEAREST) {
+        return loadTexel<F>(data + (level->getIndex(Vector2u(x.weight < 0.5f ? x.first : x.second, y.weight < 0.5f ? y.first : y.second)) * stride));
+    }
+
+    Float4 top = lerp(loadTexel<F>(data + (level->getIndex(Vector2u(x.first, y.first)) * stride)), loadTexel<F>(data + (level->getIndex(Vector2u(x.second, y.first)) * stride)), x.weight);
+    Float4 bottom = lerp(loadTexel<F>(data + (level->getIndex(Vector2u(x.first, y.second)) * stride)), loadTexel<F>(data + (level->getIndex(Vector2u(x.second, y.second)) * stride)), x.weight);
+    return lerp(top, bottom, y.weight);
+}
+
+// nan levels of detail read the first level
+template<ColorFormat F>
+static Float4 sampleLod(const std::vector<ColorBuffer*>& levels, const Sampler& sampler, float u, float v, float lod) {
+    float max_lod = static_cast<float>(levels.size() - 1);
+    lod = lod > 0.0f ? std::min(lod, max_lod) : 0.0f;
+    if (sampler.filter != TextureFilter::TRILINEAR) {
+        return normalizeTexel<F>(sampleLevel<F>(levels[static_cast<size_t>(lod + 0.5f)], sampler.filter, sampler.wrap, u, v));
+    }
+
+    size_t level = static_cast<size_t>(lod);
+    float fraction = lod - static_cast<float>(level);
+    Float4 color = sampleLevel<F>(levels[level], TextureFilter::BILINEAR, sampler.wrap, u, v);
+    if (fraction > 0.0f) {
+        color = lerp(color, sampleLevel<F>(levels[level + 1], TextureFilter::BILINEAR, sampler.wrap, u, v), fraction);
+    }
+
+    return normalizeTexel<F>(color);
+}
+
+// the level of detail of every lane follows from the longer of the screen-space steps in x and y
+// measured in texels of the first level, color receives the lanes channel by channel
+template<ColorFormat F>
+static void sampleQuad(const std::vector<ColorBuffer*>& levels, const Sampler& sampler, Float4 u, Float4 v, Float4 color[4]) {
+    Vector2u dimensions = levels[0]->getDimensions();
+    Float4 width = Float4::broadcast(static_cast<float>(dimensions.x));
+    Float4 height = Float4::broadcast(static_cast<float>(dimensions.y));
+    Float4 du_dx = ddx(u) * width;
+    Float4 dv_dx = ddx(v) * height;
+    Float4 du_dy = ddy(u) * width;
+    Float4 dv_dy = ddy(v) * height;
+
+    float footprints[4];
+    float us[4];
+    float vs[4];
+    max((du_dx * du_dx) + (dv_dx * dv_dx), (du_dy * du_dy) + (dv_dy * dv_dy)).store(footprints);
+    u.store(us);
+    v.store(vs);
+
+    // the square root of the footprint is folded into the logarithm
+    for (uint32_t lane = 0; lane < 4; ++lane) {
+        color[lane] = sampleLod<F>(levels, sampler, us[lane], vs[lane], (0.5f * std::log2(footprints[lane])) + sampler.lod_bias);
+    }
+
+    transpose4x4(color[0], color[1], color[2], color[3]);
+}
+
+// lod picks the mip level directly, single fragments have no neighbours to take derivatives from
+Vector4f Texture2D::sample(const Sampler& sampler, Vector2f coordinates, float lod) {
+    Float4 texel;
+    switch (this->format) {
+        case ColorFormat::RGBA32F:
+            texel = sampleLod<ColorFormat::RGBA32F>(this->levels, sampler, coordinates.x, coordinates.y, lod + sampler.lod_bias);
+            break;
+        case ColorFormat::RGBA16F:
+            texel = sampleLod<ColorFormat::RGBA16F>(this->levels, sampler, coordinates.x, coordinates.y, lod + sampler.lod_bias);
+            break;
+        case ColorFormat::RGB10A2_UNORM:
+            texel = sampleLod<ColorFormat::RGB10A2_UNORM>(this->levels, sampler, coordinates.x, coordinates.y, lod + sampler.lod_bias);
+            break;
+        case ColorFormat::RGBA8_UNORM:
+            texel = sampleLod<ColorFormat::RGBA8_UNORM>(this->levels, sampler, coordinates.x, coordinates.y, lod + sampler.lod_bias);
+            break;
+    }
+
+    Vector4f color;
+    texel.store(color.data);
+    return color;
+}
+
+// samples the four lanes of a fragment quad at once, the result has the channel layout of
+// QuadOutput::color and the format is dispatched once per quad
+void Texture2D::sampleQuad(const Sampler& sampler, Float4 u, Float4 v, Float4 color[4]) {
+    switch (this->format) {
+        case ColorFormat::RGBA32F:
+            apparition::sampleQuad<ColorFormat::RGBA32F>(this->levels, sampler, u, v, color);
+            break;
+        case ColorFormat::RGBA16F:
+            apparition::sampleQuad<ColorFormat::RGBA16F>(this->levels, sampler, u, v, color);
+            break;
+        case ColorFormat::RGB10A2_UNORM:
+            apparition::sampleQuad<ColorFormat::RGB10A2_UNORM>(this->levels, sampler, u, v, color);
+            break;
+        case ColorFormat::RGBA8_UNORM:
+            apparition::sampleQuad<ColorFormat::RGBA8_UNORM>(this->levels, sampler, u, v, color);
+            break;
+    }
+}
+
+Renderer::Renderer() {
+    this->frame_buffer = nullptr;
+    this->vertex_buffer = nullptr;
+    this->index_buffer = std::monostate();
+    this->shader = nullptr;
+    this->depth_function = DepthFunction::LESS_EQUAL;
+    this->depth_write = true;
+    this->vertex_layout = VertexLayout();
+    this->viewport = Viewport();
+    this->cull_mode = CullMode::NONE;
+    this->front_face = FrontFace::COUNTER_CLOCKWISE;
+    this->line_mode = LineMode::ALIASED;
+    this->thread_pool = new ThreadPool(1);
+    this->draw_id = 0;
+}
+
+Renderer::~Renderer() {
+    delete this->thread_pool;
+}
+
+void Renderer::setThreadCount(size_t thread_count) {
+    if (thread_count == 0) {
+        throw std::invalid_argument("'thread_count' must be at least 1");
+    }
+
+    if (thread_count != this->thread_pool->getThreadCount()) {
+        delete this->thread_pool;
+        this->thread_pool = new ThreadPool(thread_count);
+    }
+}
+
+size_t Renderer::getThreadCount() {
+    return this->thread_pool->getThreadCount();
+}
+
+void Renderer::setDepthFunction(DepthFunction depth_function) {
+    this->depth_function = depth_function;
+}
+
+DepthFunction Renderer::getDepthFunction() {
+    return this->depth_function;
+}
+
+void Renderer::setDepthWrite(bool depth_write) {
+    this->depth_write = depth_write;
+}
+
+bool Renderer::getDepthWrite() {
+    return this->depth_write;
+}
+
+void Renderer::setVertexLayout(VertexLayout vertex_layout) {
+    if (vertex_layout.varying_count > MAX_VARYINGS) {
+        throw std::invalid_argument("'vertex_layout' has more than " + std::to_string(MAX_VARYINGS) + " varyings");
+    }
+
+    this->vertex_layout = vertex_layout;
+}
+
+VertexLayout Renderer::getVertexLayout() {
+    return this->vertex_layout;
+}
+
+void Renderer::setViewport(Viewport viewport) {
+    if (viewport.min_depth < 0.0f || viewport.min_depth > 1.0f || viewport.max_depth < 0.0f || viewport.max_depth > 1.0f) {
+        throw std::invalid_argument("'viewport' depth range must be within [0, 1]");
+    }
+
+    this->viewport = viewport;
+}
+
+Viewport Renderer::getViewport() {
+    return this->viewport;
+}
+
+void Renderer::setCullMode(CullMode cull_mode) {
+    this->cull_mode = cull_mode;
+}
+
+CullMode Renderer::getCullMode() {
+    return this->cull_mode;
+}
+
+void Renderer::setFrontFace(FrontFace front_face) {
+    this->front_face = front_face;
+}
+
+FrontFace Renderer::getFrontFace() {
+    return this->front_face;
+}
+
+void Renderer::setLineMode(LineMode line_mode) {
+    this->line_mode = line_mode;
+}
+
+LineMode Renderer::getLineMode() {
+    return this->line_mode;
+}
+
+void Renderer::bindFrameBuffer(FrameBuffer* to_bind) {
+    if (!to_bind) {
+        throw std::invalid_argument("'to_bind' cannot be nullptr");
+    }
+
+    // draws queued for the previous frame buffer are finished first
+    this->flushPass();
+    this->frame_buffer = to_bind;
+}
+
+void Renderer::bindVertexBuffer(std::vector<Vertex>* to_bind) {
+    if (!to_bind) {
+        throw std::invalid_argument("'to_bind' cannot be nullptr");
+    }
+
+    this->vertex_buffer = to_bind;
+}
+
+void Renderer::bindIndexBuffer(std::vector<uint16_t>* to_bind) {
+    if (!to_bind) {
+        throw std::invalid_argument("'to_bind' cannot be nullptr");
+    }
+
+    this->index_buffer = to_bind;
+}
+
+void Renderer::bindIndexBuffer(std::vector<uint32_t>* to_bind) {
+    if (!to_bind) {
+        throw std::invalid_argument("'to_bind' cannot be nullptr");
+    }
+
+    this->index_buffer = to_bind;
+}
+
+void Renderer::bindIndexBuffer(std::vector<size_t>* to_bind) {
+    if (!to_bind) {
+        throw std::invalid_argument("'to_bind' cannot be nullptr");
+    }
+
+    this->index_buffer = to_bind;
+}
+
+void Renderer::unbindIndexBuffer() {
+    this->index_buffer = std::monostate();
+}
+
+void Renderer::bindShader(Shader* to_bind) {
+    if (!to_bind) {
+        throw std::invalid_argument("'to_bind' cannot be nullptr");
+    }
+
+    this->shader = to_bind;
+}
+
+// wraps the bound shader for every worker, stopping at the first shader that cannot be cloned
+static std::vector<ShaderAdapter> adaptShader(Shader* shader, size_t thread_count, std::vector<std::unique_ptr<Shader>>& clones) {
+    std::vector<ShaderAdapter> worker_shaders{ShaderAdapter(shader)};
+    for (size_t worker = 1; worker < thread_count; ++worker) {
+        std::unique_ptr<Shader> clone = shader->clone();
+        if (!clone) {
+            break;
+        }
+
+        worker_shaders.push_back(ShaderAdapter(clone.get()));
+        clones.push_back(std::move(clone));
+    }
+
+    return worker_shaders;
+}
+
+// the clones only live for the call, so the pass is flushed before returning
+void Renderer::drawLines(LineTopology topology) {
+    if (!this->shader) {
+        throw std::logic_error("No shader bound");
+    }
+
+    std::vector<std::unique_ptr<Shader>> clones;
+    std::vector<ShaderAdapter> worker_shaders = adaptShader(this->shader, this->thread_pool->getThreadCount(), clones);
+    Instance instance;
+    this->queueLines(std::move(worker_shaders), topology, &instance, 1);
+    this->flushPass();
+}
+
+void Renderer::drawTris(TriTopology topology) {
+    if (!this->shader) {
+        throw std::logic_error("No shader bound");
+    }
+
+    std::vector<std::unique_ptr<Shader>> clones;
+    std::vector<ShaderAdapter> worker_shaders = adaptShader(this->shader, this->thread_pool->getThreadCount(), clones);
+    Instance instance;
+    this->queueTris(std::move(worker_shaders), topology, &instance, 1);
+    this->flushPass();
+}
+
+void Renderer::clear(Vector4f color, float depth) {
+    if (!this->frame_buffer) {
+        throw std::logic_error("No frame buffer bound");
+    }
+
+    this->flushPass();
+    this->frame_buffer->clear(color, depth);
+}
+
+// averages the samples of the bound frame buffer's color buffer into destination once the
+// draws queued so far are rendered
+void Renderer::resolve(ColorBuffer* destination) {
+    if (!this->frame_buffer) {
+        throw std::logic_error("No frame buffer bound");
+    }
+
+    this->flushPass();
+    this->frame_buffer->getColorBuffer()->resolveSamples(destination);
+}
+
+// replays the recorded commands in order, draws are queued into one pass that is only
+// flushed when the frame buffer changes or is cleared, and after the last command, state set
+// by a command buffer does not carry over into the next one or past the call
+void Renderer::submit(const std::vector<CommandBuffer*>& command_buffers) {
+    RenderState state = this->saveState();
+    try {
+        for (CommandBuffer* command_buffer : command_buffers) {
+            if (!command_buffer) {
+                throw std::invalid_argument("'command_buffers' cannot contain nullptr");
+            }
+
+            this->restoreState(state);
+            for (const std::function<void(Renderer&)>& command : command_buffer->commands) {
+                command(*this);
+            }
+        }
+
+        this->flushPass();
+    } catch (...) {
+        this->discardPass();
+        this->restoreState(state);
+        throw;
+    }
+
+    this->restoreState(state);
+}
+
+RenderState Renderer::saveState() {
+    return RenderState{this->frame_buffer, this->vertex_buffer, this->index_buffer, this->depth_function, this->depth_write, this->vertex_layout, this->viewport, this->cull_mode, this->front_face, this->line_mode};
+}
+
+// queued draws keep their own copy of the draw state, only a frame buffer change ends the pass
+void Renderer::restoreState(const RenderState& state) {
+    if (this->frame_buffer != state.frame_buffer) {
+        this->flushPass();
+        this->frame_buffer = state.frame_buffer;
+    }
+
+    this->vertex_buffer = state.vertex_buffer;
+    this->index_buffer = state.index_buffer;
+    this->depth_function = state.depth_function;
+    this->depth_write = state.depth_write;
+    this->vertex_layout = state.vertex_layout;
+    this->viewport = state.viewport;
+    this->cull_mode = state.cull_mode;
+    this->front_face = state.front_face;
+    this->line_mode = state.line_mode;
+}
+
+void Renderer::checkDrawState() {
+    if (!this->frame_buffer) {
+        throw std::logic_error("No frame buffer bound");
+    }
+    if (!this->vertex_buffer) {
+        throw std::logic_error("No vertex buffer bound");
+    }
+
+    if (this->vertex_buffer->size() > UINT32_MAX) {
+        throw std::invalid_argument("Vertex buffer cannot hold more than " + std::to_string(UINT32_MAX) + " vertices");
+    }
+}
+
+void Renderer::checkInstances(size_t instance_count, std::vector<Instance>* instance_buffer) {
+    if (!instance_buffer) {
+        throw std::invalid_argument("'instance_buffer' cannot be nullptr");
+    }
+    if (instance_count > instance_buffer->size()) {
+        throw std::out_of_range("'instance_count' exceeds the size of 'instance_buffer'");
+    }
+}
+
+// stands in for the index buffer of non-indexed draws
+struct SequentialIndices {
+    size_t count;
+    size_t size() const { return this->count; }
+    size_t operator[](size_t i) const { return i; }
+};
+
+// calls 'visit' with the bound indices, whatever their type
+template<typename F>
+static void visitIndices(const IndexBufferBinding& index_buffer, size_t vertex_count, F&& visit) {
+    std::visit([&visit, vertex_count](auto binding) {
+        if constexpr (std::is_same_v<decltype(binding), std::monostate>) {
+            visit(SequentialIndices{vertex_count});
+        } else {
+            visit(*binding);
+        }
+    }, index_buffer);
+}
+
+std::vector<Line> Renderer::assembleLines(LineTopology topology) {
+    std::vector<Line> lines;
+    visitIndices(this->index_buffer, this->vertex_buffer->size(), [&lines, topology](const auto& indices) {
+        size_t count = indices.size();
+        switch (topology) {
+            case LineTopology::LIST:
+                if (count % 2 != 0) {
+                    throw std::invalid_argument("Index count must be divisible by 2");
+                }
+
+                lines.reserve(count / 2);
+                for (size_t i = 0; i < count; i += 2) {
+                    lines.push_back(Line(indices[i], indices[i + 1]));
+                }
+                break;
+            case LineTopology::STRIP:
+                lines.reserve(count > 1 ? count - 1 : 0);
+                for (size_t i = 0; i + 1 < count; ++i) {
+                    lines.push_back(Line(indices[i], indices[i + 1]));
+                }
+                break;
+        }
+    });
+
+    return lines;
+}
+
+std::vector<Tri> Renderer::assembleTris(TriTopology topology) {
+    std::vector<Tri> tris;
+    visitIndices(this->index_buffer, this->vertex_buffer->size(), [&tris, topology](const auto& indices) {
+        size_t count = indices.size();
+        switch (topology) {
+            case TriTopology::LIST:
+                if (count % 3 != 0) {
+                    throw std::invalid_argument("Index count must be divisible by 3");
+                }
+
+                tris.reserve(count / 3);
+                for (size_t i = 0; i < count; i += 3) {
+                    tris.push_back(Tri(indices[i], indices[i + 1], indices[i + 2]));
+                }
+                break;
+            case TriTopology::STRIP:
+                // every other tri swaps its first two vertices so the whole strip keeps one winding
+                tris.reserve(count > 2 ? count - 2 : 0);
+                for (size_t i = 0; i + 2 < count; ++i) {
+                    if (i & 1) {
+                        tris.push_back(Tri(indices[i + 1], indices[i], indices[i + 2]));
+                    } else {
+                        tris.push_back(Tri(indices[i], indices[i + 1], indices[i + 2]));
+                    }
+                }
+                break;
+            case TriTopology::FAN:
+                tris.reserve(count > 2 ? count - 2 : 0);
+                for (size_t i = 1; i + 1 < count; ++i) {
+                    tris.push_back(Tri(indices[0], indices[i], indices[i + 1]));
+                }
+                break;
+        }
+    });
+
+    return tris;
+}
+
+void Renderer::markVertices() {
+    this->prepareVertexCache();
+
+    // indices are validated with a single comparison against their maximum before any is used
+    size_t vertex_count = this->vertex_buffer->size();
+    visitIndices(this->index_buffer, vertex_count, [this, vertex_count](const auto& indices) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(indices)>, SequentialIndices>) {
+            std::fill(this->shaded_draws.begin(), this->shaded_draws.end(), this->draw_id);
+        } else {
+            if (!indices.empty() && *std::max_element(indices.begin(), indices.end()) >= vertex_count) {
+                throw std::out_of_range("Index out of range");
+            }
+
+            for (size_t index : indices) {
+                this->shaded_draws[index] = this->draw_id;
+            }
+        }
+    });
+}
+
+void Renderer::prepareVertexCache() {
+    // cache slots are tagged with the draw that shaded them, so a new draw only bumps the id
+    this->shaded_vertices.resize(this->vertex_buffer->size());
+    this->shaded_draws.resize(this->vertex_buffer->size(), 0);
+
+    ++this->draw_id;
+    if (this->draw_id == 0) {
+        std::fill(this->shaded_draws.begin(), this->shaded_draws.end(), 0);
+        this->draw_id = 1;
+    }
+}
+
+uint32_t Renderer::beginPassDraw(std::unique_ptr<PassProgram> program) {
+    PassDraw draw;
+    draw.depth_function = this->depth_function;
+    draw.depth_write = this->depth_write;
+    draw.line_mode = this->line_mode;
+    draw.program = std::move(program);
+    this->pass.draws.push_back(std::move(draw));
+    return static_cast<uint32_t>(this->pass.draws.size() - 1);
+}
+
+void Renderer::discardPass() {
+    this->pass.draws.clear();
+    this->pass.primitives.clear();
+    this->pass.line_setups.clear();
+    this->pass.tri_setups.clear();
+}
+
+void Renderer::clipLines(const std::vector<Line>& lines, const ViewportTransform& transform, uint32_t draw) {
+    size_t first = this->pass.line_setups.size();
+    LineMode line_mode = this->pass.draws[draw].line_mode;
+    for (const Line& line : lines) {
+        this->clipLine(line, transform, line_mode, this->pass.line_setups);
+    }
+
+    for (size_t i = first; i < this->pass.line_setups.size(); ++i) {
+        this->pass.primitives.push_back({PrimitiveType::LINE, draw, static_cast<uint32_t>(i)});
+    }
+}
+
+void Renderer::clipTris(const std::vector<Tri>& tris, const ViewportTransform& transform, uint32_t draw) {
+    size_t first = this->pass.tri_setups.size();
+    for (const Tri& tri : tris) {
+        this->clipTri(tri, transform, this->pass.tri_setups);
+    }
+
+    for (size_t i = first; i < this->pass.tri_setups.size(); ++i) {
+        this->pass.primitives.push_back({PrimitiveType::TRI, draw, static_cast<uint32_t>(i)});
+    }
+}
+
+// bins every primitive of the pass once and renders all tiles, fragments only record the last
+// visible primitive and are shaded when the tile is done or a smooth line needs the colors
+// beneath it, so the result matches drawing one draw at a time
+void Renderer::flushPass() {
+    if (this->pass.draws.empty()) {
+        return;
+    }
+
+    // a shader throwing leaves the pass and the tiles half rendered, both are dropped so the next
+    // flush does not replay draws whose shaders may be gone
+    try {
+        this->prepareTiles(this->frame_buffer->getDimensions());
+        for (size_t i = 0; i < this->pass.primitives.size(); ++i) {
+            const PassPrimitive& primitive = this->pass.primitives[i];
+            if (primitive.type == PrimitiveType::TRI) {
+                const TriSetup& setup = this->pass.tri_setups[primitive.setup];
+                this->binPrimitive(i, setup.min_x, setup.min_y, setup.max_x, setup.max_y);
+            } else {
+                const LineSetup& setup = this->pass.line_setups[primitive.setup];
+                this->binPrimitive(i, setup.min_x, setup.min_y, setup.max_x, setup.max_y);
+            }
+        }
+
+        // draws whose shader could not be copied for every worker keep the pass on the calling thread
+        bool parallel = true;
+        bool smooth = false;
+        for (PassDraw& draw : this->pass.draws) {
+            parallel = parallel && draw.program->getWorkerCount() >= this->thread_pool->getThreadCount();
+            smooth = smooth || draw.line_mode == LineMode::SMOOTH;
+        }
+
+        // every worker gets a tile sized coverage scratch, left zeroed between smooth lines
+        if (smooth) {
+            this->line_coverage.resize(this->thread_pool->getThreadCount() * TILE_SIZE * TILE_SIZE, 0.0f);
+            this->line_samples.resize(this->line_coverage.size(), 0);
+        }
+
+        if (parallel) {
+            this->thread_pool->run(this->tiles.size(), [this](size_t task, size_t worker) {
+                this->renderTile(this->tiles[task], worker);
+            });
+        } else {
+            for (Tile& tile : this->tiles) {
+                this->renderTile(tile, 0);
+            }
+        }
+    } catch (...) {
+        this->discardTiles();
+        this->discardPass();
+        throw;
+    }
+
+    this->discardPass();
+}
+
+// clears what an interrupted flush left behind, the quads tiles still list as covered, the
+// primitives recorded for them in the primitive buffer and the smooth line scratch
+void Renderer::discardTiles() {
+    PrimitiveBuffer* primitive_buffer = this->frame_buffer->getPrimitiveBuffer();
+    uint32_t sample_count = this->frame_buffer->getSampleCount();
+    uint32_t* covering = primitive_buffer->getData();
+
+    for (Tile& tile : this->tiles) {
+        for (uint16_t quad : tile.covered) {
+            uint32_t x = tile.min_x + ((quad % (TILE_SIZE / 2)) * 2);
+            uint32_t y = tile.min_y + ((quad / (TILE_SIZE / 2)) * 2);
+            for (uint32_t pixel_y = y; pixel_y <= std::min(y + 1, tile.max_y); ++pixel_y) {
+                for (uint32_t pixel_x = x; pixel_x <= std::min(x + 1, tile.max_x); ++pixel_x) {
+                    uint32_t* primitives = covering + (primitive_buffer->getIndex(Vector2u(pixel_x, pixel_y)) * sample_count);
+                    std::fill(primitives, primitives + sample_count, 0);
+                }
+            }
+            tile.covered_quads[quad] = false;
+        }
+
+        tile.covered.clear();
+        tile.primitives.clear();
+    }
+
+    std::fill(this->line_coverage.begin(), this->line_coverage.end(), 0.0f);
+    std::fill(this->line_samples.begin(), this->line_samples.end(), 0);
+}
+
+void Renderer::renderTile(Tile& tile, size_t worker) {
+    DepthBuffer* depth_buffer = this->frame_buffer->getDepthBuffer();
+    float epsilon = depth_buffer->getBoundsEpsilon();
+
+    // depth bounds of the whole tile, refetched only after a primitive wrote depth
+    DepthBounds tile_bounds = depth_buffer->getBounds(tile.min_x, tile.min_y, tile.max_x, tile.max_y);
+    bool tile_bounds_stale = false;
+
+    auto render = [&](auto& setup, uint32_t primitive, const PassDraw& draw) {
+        // primitives entirely behind everything the tile holds are dropped before rasterization
+        if (tile_bounds_stale) {
+            tile_bounds = depth_buffer->getBounds(tile.min_x, tile.min_y, tile.max_x, tile.max_y);
+            tile_bounds_stale = false;
+        }
+        if (!testDepthBounds(draw.depth_function, setup.min_depth, setup.max_depth, tile_bounds, epsilon)) {
+            return;
+        }
+
+        bool written;
+        if constexpr (std::is_same_v<std::remove_cvref_t<decltype(setup)>, TriSetup>) {
+            written = this->rasterizeTri(setup, primitive, draw, tile);
+        } else if (draw.line_mode == LineMode::SMOOTH) {
+            written = this->rasterizeSmoothLine(setup, draw, tile, worker);
+        } else {
+            written = this->rasterizeLine(setup, primitive, draw, tile);
+        }
+
+        // lines write too few pixels of each block to be worth a rescan, their depth range widens the bounds instead
+        if (written && draw.depth_write) {
+            uint32_t min_x = std::max(setup.min_x, tile.min_x);
+            uint32_t min_y = std::max(setup.min_y, tile.min_y);
+            uint32_t max_x = std::min(setup.max_x, tile.max_x);
+            uint32_t max_y = std::min(setup.max_y, tile.max_y);
+            if constexpr (std::is_same_v<std::remove_cvref_t<decltype(setup)>, TriSetup>) {
+                depth_buffer->invalidateBounds(min_x, min_y, max_x, max_y);
+                tile_bounds_stale = true;
+            } else {
+                depth_buffer->expandBounds(min_x, min_y, max_x, max_y, DepthBounds{setup.min_depth, setup.max_depth});
+                tile_bounds.min = std::min(tile_bounds.min, setup.min_depth);
+                tile_bounds.max = std::max(tile_bounds.max, setup.max_depth);
+            }
+        }
+    };
+
+    for (size_t i : tile.primitives) {
+        const PassPrimitive& primitive = this->pass.primitives[i];
+        const PassDraw& draw = this->pass.draws[primitive.draw];
+        if (primitive.type == PrimitiveType::TRI) {
+            render(this->pass.tri_setups[primitive.setup], i + 1, draw);
+        } else if (draw.line_mode == LineMode::SMOOTH) {
+            // smooth lines blend over the colors of everything before them in submission order,
+            // which have to be shaded first
+            this->shadeTile(tile, worker);
+            render(this->pass.line_setups[primitive.setup], i + 1, draw);
+        } else {
+            render(this->pass.line_setups[primitive.setup], i + 1, draw);
+        }
+    }
+
+    this->shadeTile(tile, worker);
+}
+
+static_assert(4 * MAX_SAMPLES <= 32, "the samples of a quad have to fit a 32-bit mask");
+
+void Renderer::shadeTile(Tile& tile, size_t worker) {
+    PrimitiveBuffer* primitive_buffer = this->frame_buffer->getPrimitiveBuffer();
+    ColorBuffer* color_buffer = this->frame_buffer->getColorBuffer();
+    uint32_t sample_count = this->frame_buffer->getSampleCount();
+
+    // all buffers of a frame buffer share a layout, so one index addresses each of them
+    uint32_t* covering = primitive_buffer->getData();
+    size_t pitch = primitive_buffer->getQuadPitch();
+
+    // only quads the pass covered are shaded, the rest of the color buffer is left untouched
+    for (uint16_t quad : tile.covered) {
+        uint32_t x = tile.min_x + ((quad % (TILE_SIZE / 2)) * 2);
+        uint32_t y = tile.min_y + ((quad / (TILE_SIZE / 2)) * 2);
+        color_buffer->resolve(x, y, x, y);
+
+        // every lane owns MAX_SAMPLES bits of the masks, one per sample
+        size_t base = primitive_buffer->getIndex(Vector2u(x, y));
+        uint32_t indices[4] = {0, 0, 0, 0};
+        uint32_t primitives[4 * MAX_SAMPLES];
+        uint32_t remaining = 0;
+        for (uint32_t lane = 0; lane < 4; ++lane) {
+            uint32_t lane_x = x + (lane & 1);
+            uint32_t lane_y = y + (lane >> 1);
+            if (lane_x <= tile.max_x && lane_y <= tile.max_y) {
+                indices[lane] = static_cast<uint32_t>(base + ((lane >> 1) * pitch) + (lane & 1));
+                for (uint32_t sample = 0; sample < sample_count; ++sample) {
+                    uint32_t bit = (lane * MAX_SAMPLES) + sample;
+                    primitives[bit] = covering[(static_cast<size_t>(indices[lane]) * sample_count) + sample];
+                    remaining |= (primitives[bit] != 0 ? 1u : 0u) << bit;
+                }
+            }
+        }
+
+        // one invocation per primitive visible in the quad, shaded once per pixel however many
+        // of its samples the primitive covers, the other lanes run as helpers
+        while (remaining) {
+            uint32_t primitive = primitives[std::countr_zero(remaining)];
+            uint32_t matched = 0;
+            for (uint32_t bits = remaining; bits; bits &= bits - 1) {
+                uint32_t bit = std::countr_zero(bits);
+                matched |= (primitives[bit] == primitive ? 1u : 0u) << bit;
+            }
+            remaining &= ~matched;
+
+            QuadInput input;
+            input.position = Vector2u(x, y);
+            input.mask = 0;
+            uint32_t sample_masks[4];
+            for (uint32_t lane = 0; lane < 4; ++lane) {
+                sample_masks[lane] = (matched >> (lane * MAX_SAMPLES)) & ((1u << MAX_SAMPLES) - 1);
+                input.mask |= (sample_masks[lane] != 0 ? 1u : 0u) << lane;
+            }
+
+            const PassPrimitive& pass_primitive = this->pass.primitives[primitive - 1];
+            const AttributeSetup& attributes = pass_primitive.type == PrimitiveType::TRI ? this->pass.tri_setups[pass_primitive.setup].attributes : this->pass.line_setups[pass_primitive.setup].attributes;
+            interpolateQuad(attributes, input);
+
+            Vector4f colors[4];
+            this->pass.draws[pass_primitive.draw].program->shadeQuad(worker, input, attributes, colors);
+            color_buffer->storeQuad(indices, sample_masks, colors);
+
+            // the primitives only live for the current pass, only the depth carries over
+            for (; matched; matched &= matched - 1) {
+                uint32_t bit = std::countr_zero(matched);
+                covering[(static_cast<size_t>(indices[bit / MAX_SAMPLES]) * sample_count) + (bit % MAX_SAMPLES)] = 0;
+            }
+        }
+
+        tile.covered_quads[quad] = false;
+    }
+
+    tile.covered.clear();
+}
+
+ViewportTransform Renderer::resolveViewport() {
+    Vector2u dimensions = this->frame_buffer->getDimensions();
+
+    Viewport viewport = this->viewport;
+    if (viewport.width == 0 || viewport.height == 0) {
+        viewport.x = 0;
+        viewport.y = 0;
+        viewport.width = dimensions.x;
+        viewport.height = dimensions.y;
+    }
+
+    ViewportTransform transform;
+    transform.scale_x = viewport.width * 0.5f;
+    transform.scale_y = viewport.height * 0.5f;
+    transform.scale_z = (viewport.max_depth - viewport.min_depth) * 0.5f;
+    transform.offset_x = viewport.x + transform.scale_x;
+    transform.offset_y = viewport.y + transform.scale_y;
+    transform.offset_z = viewport.min_depth + transform.scale_z;
+    transform.guard_x = 1.0f + (GUARD_BAND / transform.scale_x);
+    transform.guard_y = 1.0f + (GUARD_BAND / transform.scale_y);
+
+    // an empty scissor rectangle has min above max, setup then rejects every primitive
+    int64_t min_x = std::max<int64_t>(viewport.x, 0);
+    int64_t min_y = std::max<int64_t>(viewport.y, 0);
+    int64_t max_x = std::min<int64_t>(static_cast<int64_t>(viewport.x) + viewport.width, dimensions.x) - 1;
+    int64_t max_y = std::min<int64_t>(static_cast<int64_t>(viewport.y) + viewport.height, dimensions.y) - 1;
+    if (min_x > max_x || min_y > max_y) {
+        min_x = min_y = 1;
+        max_x = max_y = 0;
+    }
+
+    transform.min_x = min_x;
+    transform.min_y = min_y;
+    transform.max_x = max_x;
+    transform.max_y = max_y;
+
+    return transform;
+}
+
+void Renderer::prepareTiles(Vector2u dimensions) {
+    if (this->tiles.empty() || this->tiles_dimensions.x != dimensions.x || this->tiles_dimensions.y != dimensions.y) {
+        this->tiles.clear();
+        this->tiles_dimensions = dimensions;
+
+        for (uint32_t y = 0; y < dimensions.y; y += TILE_SIZE) {
+            for (uint32_t x = 0; x < dimensions.x; x += TILE_SIZE) {
+                Tile tile;
+                tile.min_x = x;
+                tile.min_y = y;
+                tile.max_x = std::min(x + TILE_SIZE, dimensions.x) - 1;
+                tile.max_y = std::min(y + TILE_SIZE, dimensions.y) - 1;
+                this->tiles.push_back(tile);
+            }
+        }
+    }
+
+    for (Tile& tile : this->tiles) {
+        tile.primitives.clear();
+    }
+}
+
+void Renderer::binPrimitive(size_t index, uint32_t min_x, uint32_t min_y, uint32_t max_x, uint32_t max_y) {
+    // primitives are appended in submission order so every tile replays them in that order
+    size_t tile_columns = (this->tiles_dimensions.x + TILE_SIZE - 1) / TILE_SIZE;
+
+    for (uint32_t tile_y = min_y / TILE_SIZE; tile_y <= max_y / TILE_SIZE; ++tile_y) {
+        for (uint32_t tile_x = min_x / TILE_SIZE; tile_x <= max_x / TILE_SIZE; ++tile_x) {
+            this->tiles[(tile_y * tile_columns) + tile_x].primitives.push_back(index);
+        }
+    }
+}
+
+// clip space planes with inside where dot(plane, position) >= 0, the near plane, the w plane and
+// the guard band clip, the view volume planes only reject primitives lying completely outside of
+// one of them
+enum ClipPlane : uint32_t {
+    CLIP_NEAR,
+    CLIP_W,
+    CLIP_GUARD_LEFT,
+    CLIP_GUARD_RIGHT,
+    CLIP_GUARD_BOTTOM,
+    CLIP_GUARD_TOP,
+    CLIP_LEFT,
+    CLIP_RIGHT,
+    CLIP_BOTTOM,
+    CLIP_TOP,
+    CLIP_FAR,
+    CLIP_PLANE_COUNT
+};
+
+constexpr uint32_t CLIPPING_PLANES = (1u << CLIP_NEAR) | (1u << CLIP_W) | (1u << CLIP_GUARD_LEFT) | (1u << CLIP_GUARD_RIGHT) | (1u << CLIP_GUARD_BOTTOM) | (1u << CLIP_GUARD_TOP);
+
+static void getClipPlanes(const ViewportTransform& transform, Vector4f planes[CLIP_PLANE_COUNT]) {
+    planes[CLIP_NEAR] = Vector4f(0.0f, 0.0f, 1.0f, 1.0f);
+    planes[CLIP_W] = Vector4f(0.0f, 0.0f, 0.0f, 1.0f);
+    planes[CLIP_GUARD_LEFT] = Vector4f(1.0f, 0.0f, 0.0f, transform.guard_x);
+    planes[CLIP_GUARD_RIGHT] = Vector4f(-1.0f, 0.0f, 0.0f, transform.guard_x);
+    planes[CLIP_GUARD_BOTTOM] = Vector4f(0.0f, 1.0f, 0.0f, transform.guard_y);
+    planes[CLIP_GUARD_TOP] = Vector4f(0.0f, -1.0f, 0.0f, transform.guard_y);
+    planes[CLIP_LEFT] = Vector4f(1.0f, 0.0f, 0.0f, 1.0f);
+    planes[CLIP_RIGHT] = Vector4f(-1.0f, 0.0f, 0.0f, 1.0f);
+    planes[CLIP_BOTTOM] = Vector4f(0.0f, 1.0f, 0.0f, 1.0f);
+    planes[CLIP_TOP] = Vector4f(0.0f, -1.0f, 0.0f, 1.0f);
+    planes[CLIP_FAR] = Vector4f(0.0f, 0.0f, -1.0f, 1.0f);
+}
+
+// the near plane and the guard band still pass w == 0 at x = y = 0, so the w plane keeps w at
+// least CLIP_W_EPSILON and the perspective divide finite
+constexpr float CLIP_W_EPSILON = 1e-6f;
+
+static float getPlaneDistance(const Vector4f& position, const Vector4f planes[CLIP_PLANE_COUNT], uint32_t plane) {
+    float distance = position.dot(planes[plane]);
+    return plane == CLIP_W ? distance - CLIP_W_EPSILON : distance;
+}
+
+// bit i is set if the position is outside plane i
+static uint32_t getOutcode(const Vector4f& position, const Vector4f planes[CLIP_PLANE_COUNT]) {
+    uint32_t outcode = 0;
+    for (uint32_t i = 0; i < CLIP_PLANE_COUNT; ++i) {
+        outcode |= (getPlaneDistance(position, planes, i) < 0.0f ? 1u : 0u) << i;
+    }
+
+    return outcode;
+}
+
+// clip space interpolation, varyings are still linear here because the divide by w comes later
+static Vertex lerpVertex(const Vertex& from, const Vertex& to, float t, uint32_t varying_count) {
+    Vertex vertex;
+    vertex.position = from.position + ((to.position - from.position) * t);
+    for (uint32_t i = 0; i < varying_count; ++i) {
+        vertex.varyings[i] = from.varyings[i] + ((to.varyings[i] - from.varyings[i]) * t);
+    }
+
+    return vertex;
+}
+
+void Renderer::clipLine(const Line& line, const ViewportTransform& transform, LineMode line_mode, std::vector<LineSetup>& setups) {
+    Vector4f planes[CLIP_PLANE_COUNT];
+    getClipPlanes(transform, planes);
+
+    const Vertex& vertex_0 = this->shaded_vertices[line.vertex_0];
+    const Vertex& vertex_1 = this->shaded_vertices[line.vertex_1];
+
+    uint32_t outcode_0 = getOutcode(vertex_0.position, planes);
+    uint32_t outcode_1 = getOutcode(vertex_1.position, planes);
+    if (outcode_0 & outcode_1) {
+        return;
+    }
+
+    if (!(outcode_0 | outcode_1)) {
+        std::optional<LineSetup> setup = this->setupLine(vertex_0, vertex_1, transform, line_mode);
+        if (setup) {
+            setups.push_back(*setup);
+        }
+        return;
+    }
+
+    // lines are cut to the view volume itself, so the rasterizer never walks pixels off screen
+    float t0 = 0.0f;
+    float t1 = 1.0f;
+    for (uint32_t i = 0; i < CLIP_PLANE_COUNT; ++i) {
+        float distance_0 = getPlaneDistance(vertex_0.position, planes, i);
+        float distance_1 = getPlaneDistance(vertex_1.position, planes, i);
+        if (distance_0 < 0.0f && distance_1 < 0.0f) {
+            return;
+        }
+
+        if (distance_0 < 0.0f) {
+            t0 = std::max(t0, distance_0 / (distance_0 - distance_1));
+        } else if (distance_1 < 0.0f) {
+            t1 = std::min(t1, distance_0 / (distance_0 - distance_1));
+        }
+    }
+
+    if (t0 > t1) {
+        return;
+    }
+
+    uint32_t varying_count = this->vertex_layout.varying_count;
+    Vertex clipped_0 = lerpVertex(vertex_0, vertex_1, t0, varying_count);
+    Vertex clipped_1 = lerpVertex(vertex_0, vertex_1, t1, varying_count);
+    std::optional<LineSetup> setup = this->setupLine(clipped_0, clipped_1, transform, line_mode);
+    if (setup) {
+        setups.push_back(*setup);
+    }
+}
+
+std::optional<LineSetup> Renderer::setupLine(const Vertex& vertex_0, const Vertex& vertex_1, const ViewportTransform& transform, LineMode line_mode) {
+    if (transform.min_x > transform.max_x) {
+        return std::nullopt;
+    }
+
+    float inverse_w_0 = 1.0f / vertex_0.position.w;
+    float inverse_w_1 = 1.0f / vertex_1.position.w;
+    float start_x = (vertex_0.position.x * inverse_w_0 * transform.scale_x) + transform.offset_x - 0.5f;
+    float start_y = (vertex_0.position.y * inverse_w_0 * transform.scale_y) + transform.offset_y - 0.5f;
+    float end_x = (vertex_1.position.x * inverse_w_1 * transform.scale_x) + transform.offset_x - 0.5f;
+    float end_y = (vertex_1.position.y * inverse_w_1 * transform.scale_y) + transform.offset_y - 0.5f;
+
+    // clipping keeps the divide finite, this only catches positions a shader left nan or infinite
+    if (!std::isfinite(start_x) || !std::isfinite(start_y) || !std::isfinite(end_x) || !std::isfinite(end_y)) {
+        return std::nullopt;
+    }
+
+    // lines are set up with pixel centers on integer positions, half a pixel below the window
+    // position of the center, endpoints of a clipped line can land just past the viewport
+    LineSetup setup;
+    float min_x = static_cast<float>(transform.min_x) - 0.5f;
+    float min_y = static_cast<float>(transform.min_y) - 0.5f;
+    float max_x = static_cast<float>(transform.max_x) + 0.5f;
+    float max_y = static_cast<float>(transform.max_y) + 0.5f;
+    setup.start_x = std::clamp(start_x, min_x, max_x);
+    setup.start_y = std::clamp(start_y, min_y, max_y);
+    setup.end_x = std::clamp(end_x, min_x, max_x);
+    setup.end_y = std::clamp(end_y, min_y, max_y);
+    setup.x0 = std::clamp<int32_t>(std::lround(setup.start_x), transform.min_x, transform.max_x);
+    setup.y0 = std::clamp<int32_t>(std::lround(setup.start_y), transform.min_y, transform.max_y);
+    setup.x1 = std::clamp<int32_t>(std::lround(setup.end_x), transform.min_x, transform.max_x);
+    setup.y1 = std::clamp<int32_t>(std::lround(setup.end_y), transform.min_y, transform.max_y);
+
+    // attributes vary with the projection t onto the line, 0 at the first and 1 at the second endpoint,
+    // aliased lines measure t between the rounded endpoints they walk and smooth lines between the exact ones
+    bool smooth = line_mode == LineMode::SMOOTH;
+    float line_dx = smooth ? setup.end_x - setup.start_x : static_cast<float>(setup.x1 - setup.x0);
+    float line_dy = smooth ? setup.end_y - setup.start_y : static_cast<float>(setup.y1 - setup.y0);
+    float offset_x = smooth ? setup.start_x - static_cast<float>(setup.x0) : 0.0f;
+    float offset_y = smooth ? setup.start_y - static_cast<float>(setup.y0) : 0.0f;
+    float length_squared = (line_dx * line_dx) + (line_dy * line_dy);
+    float t_dx = length_squared > 0.0f ? line_dx / length_squared : 0.0f;
+    float t_dy = length_squared > 0.0f ? line_dy / length_squared : 0.0f;
+
+    auto line_plane = [t_dx, t_dy, offset_x, offset_y](float value_0, float value_1) {
+        float a = t_dx * (value_1 - value_0);
+        float b = t_dy * (value_1 - value_0);
+        return AttributePlane{a, b, value_0 - (a * offset_x) - (b * offset_y)};
+    };
+
+    AttributeSetup& attributes = setup.attributes;
+    attributes.origin_x = setup.x0;
+    attributes.origin_y = setup.y0;
+    attributes.varying_count = this->vertex_layout.varying_count;
+    float depth_0 = (vertex_0.position.z * inverse_w_0 * transform.scale_z) + transform.offset_z;
+    float depth_1 = (vertex_1.position.z * inverse_w_1 * transform.scale_z) + transform.offset_z;
+    attributes.depth = line_plane(depth_0, depth_1);
+    setup.min_depth = std::min(depth_0, depth_1);
+    setup.max_depth = std::max(depth_0, depth_1);
+    attributes.inverse_w = line_plane(inverse_w_0, inverse_w_1);
+    for (uint32_t i = 0; i < attributes.varying_count; ++i) {
+        attributes.varyings[i] = line_plane(vertex_0.varyings[i] * inverse_w_0, vertex_1.varyings[i] * inverse_w_1);
+    }
+
+    if (smooth) {
+        // wu's algorithm touches the pixel below the line position and the one after it on both axes
+        setup.min_x = std::clamp<int32_t>(static_cast<int32_t>(std::floor(std::min(setup.start_x, setup.end_x))), transform.min_x, transform.max_x);
+        setup.min_y = std::clamp<int32_t>(static_cast<int32_t>(std::floor(std::min(setup.start_y, setup.end_y))), transform.min_y, transform.max_y);
+        setup.max_x = std::clamp<int32_t>(static_cast<int32_t>(std::floor(std::max(setup.start_x, setup.end_x))) + 1, transform.min_x, transform.max_x);
+        setup.max_y = std::clamp<int32_t>(static_cast<int32_t>(std::floor(std::max(setup.start_y, setup.end_y))) + 1, transform.min_y, transform.max_y);
+    } else {
+        setup.min_x = std::min(setup.x0, setup.x1);
+        setup.min_y = std::min(setup.y0, setup.y1);
+        setup.max_x = std::max(setup.x0, setup.x1);
+        setup.max_y = std::max(setup.y0, setup.y1);
+    }
+
+    return setup;
+}
+
+bool Renderer::rasterizeLine(LineSetup& setup, uint32_t primitive, const PassDraw& draw, Tile& tile) {
+    DepthBuffer* depth_buffer = this->frame_buffer->getDepthBuffer();
+    uint32_t* covering = this->frame_buffer->getPrimitiveBuffer()->getData();
+    uint32_t sample_count = this->frame_buffer->getSampleCount();
+    bool written = false;
+
+    // bresenham's algorithm in closed form, after i steps along the major axis the line has moved
+    // (2 * i * minor_delta + major_delta) / (2 * major_delta) pixels along the minor one, so a tile
+    // starts at its first step rather than walking the whole line and still hits the same pixels
+    int32_t start[2] = {setup.x0, setup.y0};
+    int32_t end[2] = {setup.x1, setup.y1};
+    int32_t tile_min[2] = {static_cast<int32_t>(tile.min_x), static_cast<int32_t>(tile.min_y)};
+    int32_t tile_max[2] = {static_cast<int32_t>(tile.max_x), static_cast<int32_t>(tile.max_y)};
+    uint32_t major = std::abs(end[0] - start[0]) >= std::abs(end[1] - start[1]) ? 0 : 1;
+    uint32_t minor = 1 - major;
+    int64_t major_delta = std::abs(end[major] - start[major]);
+    int64_t minor_delta = std::abs(end[minor] - start[minor]);
+    int32_t major_step = end[major] < start[major] ? -1 : 1;
+    int32_t minor_step = end[minor] < start[minor] ? -1 : 1;
+
+    // offsets from the start along an axis that stay inside the tile
+    auto tile_offsets = [&](uint32_t axis, int32_t step) {
+        if (step > 0) {
+            return std::pair<int64_t, int64_t>(tile_min[axis] - start[axis], tile_max[axis] - start[axis]);
+        }
+        return std::pair<int64_t, int64_t>(start[axis] - tile_max[axis], start[axis] - tile_min[axis]);
+    };
+
+    auto [major_min, major_max] = tile_offsets(major, major_step);
+    int64_t first = std::max<int64_t>(major_min, 0);
+    int64_t last = std::min<int64_t>(major_max, major_delta);
+
+    // the minor offset never decreases, so the steps inside the tile on the minor axis are a range too
+    auto [minor_min, minor_max] = tile_offsets(minor, minor_step);
+    if (minor_max < 0 || (minor_delta == 0 && minor_min > 0)) {
+        return false;
+    }
+
+    if (minor_delta > 0) {
+        if (minor_min > 0) {
+            first = std::max(first, ((2 * major_delta * minor_min) - major_delta + (2 * minor_delta) - 1) / (2 * minor_delta));
+        }
+        last = std::min(last, ((2 * major_delta * (minor_max + 1)) - major_delta - 1) / (2 * minor_delta));
+    }
+
+    if (first > last) {
+        return false;
+    }
+
+    int64_t denominator = std::max<int64_t>(2 * major_delta, 1);
+    int64_t numerator = (2 * first * minor_delta) + major_delta;
+    int64_t error = numerator % denominator;
+    int32_t position[2];
+    position[major] = start[major] + (major_step * static_cast<int32_t>(first));
+    position[minor] = start[minor] + (minor_step * static_cast<int32_t>(numerator / denominator));
+
+    for (int64_t i = first; i <= last; ++i) {
+        uint32_t x = position[0];
+        uint32_t y = position[1];
+        float depth = evaluatePlane(setup.attributes.depth, static_cast<float>(position[0] - setup.x0), static_cast<float>(position[1] - setup.y0));
+
+        // early depth test, occluded fragments never reach the fragment shader, lines cover
+        // every sample of their pixels
+        depth_buffer->resolve(x, y, x, y);
+        size_t index = depth_buffer->getIndex(Vector2u(x, y));
+        for (uint32_t sample = 0; sample < sample_count; ++sample) {
+            if (depth_buffer->test(index, sample, draw.depth_function, depth, draw.depth_write)) {
+                covering[(index * sample_count) + sample] = primitive;
+                tile.cover(x, y);
+                written = true;
+            }
+        }
+
+        position[major] += major_step;
+        error += 2 * minor_delta;
+        if (error >= denominator) {
+            error -= denominator;
+            position[minor] += minor_step;
+        }
+    }
+
+    return written;
+}
+
+// wu's algorithm, every step along the major axis splits its coverage between the two pixels the
+// line passes between and the end pixels are faded by how much of them the line spans, covered
+// quads are shaded and blended before returning so later smooth lines blend over this one
+bool Renderer::rasterizeSmoothLine(LineSetup& setup, const PassDraw& draw, Tile& tile, size_t worker) {
+    DepthBuffer* depth_buffer = this->frame_buffer->getDepthBuffer();
+    ColorBuffer* color_buffer = this->frame_buffer->getColorBuffer();
+    uint32_t sample_count = this->frame_buffer->getSampleCount();
+    float* coverage = this->line_coverage.data() + (worker * TILE_SIZE * TILE_SIZE);
+    uint8_t* covered_samples = this->line_samples.data() + (worker * TILE_SIZE * TILE_SIZE);
+    bool written = false;
+
+    float start[2] = {setup.start_x, setup.start_y};
+    float end[2] = {setup.end_x, setup.end_y};
+    uint32_t major = std::abs(end[0] - start[0]) >= std::abs(end[1] - start[1]) ? 0 : 1;
+    uint32_t minor = 1 - major;
+    if (end[major] < start[major]) {
+        std::swap(start, end);
+    }
+
+    float length = end[major] - start[major];
+    float gradient = length > 0.0f ? (end[minor] - start[minor]) / length : 0.0f;
+
+    // pixels are kept inside the tile and the scissored bounding box
+    int32_t clip_min[2] = {static_cast<int32_t>(std::max(tile.min_x, setup.min_x)), static_cast<int32_t>(std::max(tile.min_y, setup.min_y))};
+    int32_t clip_max[2] = {static_cast<int32_t>(std::min(tile.max_x, setup.max_x)), static_cast<int32_t>(std::min(tile.max_y, setup.max_y))};
+
+    int32_t first = std::lround(start[major]);
+    int32_t last = std::lround(end[major]);
+    int32_t from = std::max(first, clip_min[major]);
+    int32_t to = std::min(last, clip_max[major]);
+
+    // steps whose pixels can reach the tile on the minor axis, padded since the pixel checks are exact
+    if (gradient != 0.0f && from <= to) {
+        float enter = start[major] + ((static_cast<float>(clip_min[minor] - 1) - start[minor]) / gradient);
+        float exit = start[major] + ((static_cast<float>(clip_max[minor] + 1) - start[minor]) / gradient);
+        if (enter > exit) {
+            std::swap(enter, exit);
+        }
+        from = static_cast<int32_t>(std::clamp(std::floor(enter) - 1.0f, static_cast<float>(from), static_cast<float>(to) + 1.0f));
+        to = static_cast<int32_t>(std::clamp(std::ceil(exit) + 1.0f, static_cast<float>(from) - 1.0f, static_cast<float>(to)));
+    }
+
+    // the minor position is evaluated at every step rather than accumulated so it does not depend on the tile
+    for (int32_t step = from; step <= to; ++step) {
+        float line_minor = start[minor] + (gradient * (static_cast<float>(step) - start[major]));
+        float weight = 1.0f;
+        if (first == last) {
+            weight = length;
+        } else if (step == first) {
+            weight = static_cast<float>(first) + 0.5f - start[major];
+        } else if (step == last) {
+            weight = end[major] - (static_cast<float>(last) - 0.5f);
+        }
+        weight = std::clamp(weight, 0.0f, 1.0f);
+
+        float below = std::floor(line_minor);
+        float fraction = line_minor - below;
+        float weights[2] = {(1.0f - fraction) * weight, fraction * weight};
+        for (int32_t side = 0; side < 2; ++side) {
+            int32_t pixel[2];
+            pixel[major] = step;
+            pixel[minor] = static_cast<int32_t>(below) + side;
+            if (weights[side] <= 0.0f || pixel[minor] < clip_min[minor] || pixel[minor] > clip_max[minor]) {
+                continue;
+            }
+
+            uint32_t x = pixel[0];
+            uint32_t y = pixel[1];
+            float depth = evaluatePlane(setup.attributes.depth, static_cast<float>(pixel[0] - setup.x0), static_cast<float>(pixel[1] - setup.y0));
+
+            depth_buffer->resolve(x, y, x, y);
+            size_t index = depth_buffer->getIndex(Vector2u(x, y));
+            uint32_t samples = 0;
+            for (uint32_t sample = 0; sample < sample_count; ++sample) {
+                samples |= (depth_buffer->test(index, sample, draw.depth_function, depth, draw.depth_write) ? 1u : 0u) << sample;
+            }
+
+            if (samples) {
+                size_t scratch = ((y - tile.min_y) * TILE_SIZE) + (x - tile.min_x);
+                coverage[scratch] = weights[side];
+                covered_samples[scratch] = static_cast<uint8_t>(samples);
+                tile.cover(x, y);
+                written = true;
+            }
+        }
+    }
+
+    size_t pitch = color_buffer->getQuadPitch();
+    for (uint16_t quad : tile.covered) {
+        uint32_t x = tile.min_x + ((quad % (TILE_SIZE / 2)) * 2);
+        uint32_t y = tile.min_y + ((quad / (TILE_SIZE / 2)) * 2);
+        color_buffer->resolve(x, y, x, y);
+
+        size_t base = color_buffer->getIndex(Vector2u(x, y));
+        uint32_t indices[4] = {0, 0, 0, 0};
+        uint32_t sample_masks[4] = {0, 0, 0, 0};
+        float lane_coverage[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+        QuadInput input;
+        input.position = Vector2u(x, y);
+        input.mask = 0;
+        for (uint32_t lane = 0; lane < 4; ++lane) {
+            uint32_t lane_x = x + (lane & 1);
+            uint32_t lane_y = y + (lane >> 1);
+            if (lane_x <= tile.max_x && lane_y <= tile.max_y) {
+                size_t scratch = ((lane_y - tile.min_y) * TILE_SIZE) + (lane_x - tile.min_x);
+                indices[lane] = static_cast<uint32_t>(base + ((lane >> 1) * pitch) + (lane & 1));
+                sample_masks[lane] = covered_samples[scratch];
+                lane_coverage[lane] = coverage[scratch];
+                input.mask |= (sample_masks[lane] != 0 ? 1u : 0u) << lane;
+                coverage[scratch] = 0.0f;
+                covered_samples[scratch] = 0;
+            }
+        }
+
+        interpolateQuad(setup.attributes, input);
+
+        Vector4f colors[4];
+        draw.program->shadeQuad(worker, input, setup.attributes, colors);
+        color_buffer->blendQuad(indices, sample_masks, colors, lane_coverage);
+        tile.covered_quads[quad] = false;
+    }
+
+    tile.covered.clear();
+
+    return written;
+}
+
+void Renderer::clipTri(const Tri& tri, const ViewportTransform& transform, std::vector<TriSetup>& setups) {
+    Vector4f planes[CLIP_PLANE_COUNT];
+    getClipPlanes(transform, planes);
+
+    const Vertex& vertex_0 = this->shaded_vertices[tri.vertex_0];
+    const Vertex& vertex_1 = this->shaded_vertices[tri.vertex_1];
+    const Vertex& vertex_2 = this->shaded_vertices[tri.vertex_2];
+
+    uint32_t outcode_0 = getOutcode(vertex_0.position, planes);
+    uint32_t outcode_1 = getOutcode(vertex_1.position, planes);
+    uint32_t outcode_2 = getOutcode(vertex_2.position, planes);
+    if (outcode_0 & outcode_1 & outcode_2) {
+        return;
+    }
+
+    // tris inside the near plane and the guard band go straight to setup, the scissor does the rest
+    if (!((outcode_0 | outcode_1 | outcode_2) & CLIPPING_PLANES)) {
+        std::optional<TriSetup> setup = this->setupTri(vertex_0, vertex_1, vertex_2, transform);
+        if (setup) {
+            setups.push_back(*setup);
+        }
+        return;
+    }
+
+    // sutherland-hodgman against the clipping planes, each one adds at most one vertex
+    constexpr size_t MAX_CLIPPED_VERTICES = 3 + CLIP_GUARD_TOP + 1;
+    Vertex buffers[2][MAX_CLIPPED_VERTICES];
+    Vertex* polygon = buffers[0];
+    Vertex* clipped = buffers[1];
+    polygon[0] = vertex_0;
+    polygon[1] = vertex_1;
+    polygon[2] = vertex_2;
+    size_t count = 3;
+
+    uint32_t varying_count = this->vertex_layout.varying_count;
+    uint32_t crossed = (outcode_0 | outcode_1 | outcode_2) & CLIPPING_PLANES;
+    for (uint32_t i = 0; i < CLIP_PLANE_COUNT && count >= 3; ++i) {
+        if (!(crossed & (1u << i))) {
+            continue;
+        }
+
+        size_t clipped_count = 0;
+        for (size_t j = 0; j < count; ++j) {
+            const Vertex& from = polygon[j];
+            const Vertex& to = polygon[(j + 1) % count];
+            float distance_from = getPlaneDistance(from.position, planes, i);
+            float distance_to = getPlaneDistance(to.position, planes, i);
+
+            if (distance_from >= 0.0f) {
+                clipped[clipped_count++] = from;
+            }
+            if ((distance_from >= 0.0f) != (distance_to >= 0.0f)) {
+                clipped[clipped_count++] = lerpVertex(from, to, distance_from / (distance_from - distance_to), varying_count);
+            }
+        }
+
+        std::swap(polygon, clipped);
+        count = clipped_count;
+    }
+
+    // the clipped polygon is convex, fan it out from its first vertex
+    for (size_t i = 1; i + 1 < count; ++i) {
+        std::optional<TriSetup> setup = this->setupTri(polygon[0], polygon[i], polygon[i + 1], transform);
+        if (setup) {
+            setups.push_back(*setup);
+        }
+    }
+}
+
+std::optional<TriSetup> Renderer::setupTri(const Vertex& vertex_0, const Vertex& vertex_1, const Vertex& vertex_2, const ViewportTransform& transform) {
+    float inverse_w_0 = 1.0f / vertex_0.position.w;
+    float inverse_w_1 = 1.0f / vertex_1.position.w;
+    float inverse_w_2 = 1.0f / vertex_2.position.w;
+
+    // perspective divide and viewport transform, then snap vertices to the subpixel grid
+    float screen_x0 = ((vertex_0.position.x * inverse_w_0 * transform.scale_x) + transform.offset_x) * SUBPIXEL_ONE;
+    float screen_x1 = ((vertex_1.position.x * inverse_w_1 * transform.scale_x) + transform.offset_x) * SUBPIXEL_ONE;
+    float screen_x2 = ((vertex_2.position.x * inverse_w_2 * transform.scale_x) + transform.offset_x) * SUBPIXEL_ONE;
+    float screen_y0 = ((vertex_0.position.y * inverse_w_0 * transform.scale_y) + transform.offset_y) * SUBPIXEL_ONE;
+    float screen_y1 = ((vertex_1.position.y * inverse_w_1 * transform.scale_y) + transform.offset_y) * SUBPIXEL_ONE;
+    float screen_y2 = ((vertex_2.position.y * inverse_w_2 * transform.scale_y) + transform.offset_y) * SUBPIXEL_ONE;
+
+    // clipping keeps the divide finite, this only catches positions a shader left nan or infinite
+    if (!std::isfinite(screen_x0) || !std::isfinite(screen_x1) || !std::isfinite(screen_x2) || !std::isfinite(screen_y0) || !std::isfinite(screen_y1) || !std::isfinite(screen_y2)) {
+        return std::nullopt;
+    }
+
+    int64_t x0 = std::llround(screen_x0);
+    int64_t x1 = std::llround(screen_x1);
+    int64_t x2 = std::llround(screen_x2);
+    int64_t y0 = std::llround(screen_y0);
+    int64_t y1 = std::llround(screen_y1);
+    int64_t y2 = std::llround(screen_y2);
+
+    // positive area means counter-clockwise in the y-up viewport
+    int64_t area = ((y1 - y2) * (x0 - x2)) + ((x2 - x1) * (y0 - y2));
+    if (area == 0) {
+        return std::nullopt;
+    }
+
+    bool front_facing = (area > 0) == (this->front_face == FrontFace::COUNTER_CLOCKWISE);
+    if ((this->cull_mode == CullMode::BACK && !front_facing) || (this->cull_mode == CullMode::FRONT && front_facing)) {
+        return std::nullopt;
+    }
+
+    // clamp the bounding box to the scissor rectangle, pixels are sampled at their centers, the
+    // samples of a multisampled pixel can be covered by a tri touching any part of the pixel
+    constexpr int64_t HALF = SUBPIXEL_ONE / 2;
+    int64_t reach = this->frame_buffer->getSampleCount() > 1 ? HALF : 0;
+    int64_t min_x = std::max<int64_t>((std::min({x0, x1, x2}) - HALF - reach + SUBPIXEL_ONE - 1) >> SUBPIXEL_BITS, transform.min_x);
+    int64_t min_y = std::max<int64_t>((std::min({y0, y1, y2}) - HALF - reach + SUBPIXEL_ONE - 1) >> SUBPIXEL_BITS, transform.min_y);
+    int64_t max_x = std::min<int64_t>((std::max({x0, x1, x2}) - HALF + reach) >> SUBPIXEL_BITS, transform.max_x);
+    int64_t max_y = std::min<int64_t>((std::max({y0, y1, y2}) - HALF + reach) >> SUBPIXEL_BITS, transform.max_y);
+    if (min_x > max_x || min_y > max_y) {
+        return std::nullopt;
+    }
+
+    TriSetup setup;
+    setup.min_x = min_x;
+    setup.min_y = min_y;
+    setup.max_x = max_x;
+    setup.max_y = max_y;
+
+    // edge i is zero on the edge opposite vertex i and equals the doubled area at vertex i, the
+    // half pixel in c moves the samples from the pixel corners to their centers
+    setup.edges[0] = {(y1 - y2) * SUBPIXEL_ONE, (x2 - x1) * SUBPIXEL_ONE, -((y1 - y2) * (x2 - HALF)) - ((x2 - x1) * (y2 - HALF))};
+    setup.edges[1] = {(y2 - y0) * SUBPIXEL_ONE, (x0 - x2) * SUBPIXEL_ONE, -((y2 - y0) * (x2 - HALF)) - ((x0 - x2) * (y2 - HALF))};
+    setup.edges[2] = {(y0 - y1) * SUBPIXEL_ONE, (x1 - x0) * SUBPIXEL_ONE, -((y0 - y1) * (x0 - HALF)) - ((x1 - x0) * (y0 - HALF))};
+
+    // flip clockwise tris so that covered pixels always have non-negative edge values
+    if (area < 0) {
+        area = -area;
+        for (EdgeFunction& edge : setup.edges) {
+            edge.a = -edge.a;
+            edge.b = -edge.b;
+            edge.c = -edge.c;
+        }
+    }
+
+    // attribute planes are anchored at the bounding box origin, where the exact edge values keep
+    // them precise regardless of how far the tri is from the frame buffer origin
+    double inverse_area = 1.0 / static_cast<double>(area);
+    int64_t origin_e0 = (setup.edges[0].a * min_x) + (setup.edges[0].b * min_y) + setup.edges[0].c;
+    int64_t origin_e1 = (setup.edges[1].a * min_x) + (setup.edges[1].b * min_y) + setup.edges[1].c;
+
+    // top-left fill rule, the inside of a left edge lies towards +x and the inside of a top edge
+    // towards -y in the y-up viewport, two tris sharing an edge see it from opposite sides, so
+    // exactly one of them owns centers on it, the planes above use the unbiased values
+    for (EdgeFunction& edge : setup.edges) {
+        bool left = edge.a > 0;
+        bool top = edge.a == 0 && edge.b < 0;
+        if (!left && !top) {
+            edge.c -= 1;
+        }
+    }
+
+    auto tri_plane = [&setup, inverse_area, origin_e0, origin_e1](float value_0, float value_1, float value_2) {
+        double delta_0 = static_cast<double>(value_0) - value_2;
+        double delta_1 = static_cast<double>(value_1) - value_2;
+        return AttributePlane{
+            static_cast<float>(((setup.edges[0].a * delta_0) + (setup.edges[1].a * delta_1)) * inverse_area),
+            static_cast<float>(((setup.edges[0].b * delta_0) + (setup.edges[1].b * delta_1)) * inverse_area),
+            static_cast<float>(value_2 + (((origin_e0 * delta_0) + (origin_e1 * delta_1)) * inverse_area))
+        };
+    };
+
+    AttributeSetup& attributes = setup.attributes;
+    attributes.origin_x = static_cast<int32_t>(min_x);
+    attributes.origin_y = static_cast<int32_t>(min_y);
+    attributes.varying_count = this->vertex_layout.varying_count;
+    float depth_0 = (vertex_0.position.z * inverse_w_0 * transform.scale_z) + transform.offset_z;
+    float depth_1 = (vertex_1.position.z * inverse_w_1 * transform.scale_z) + transform.offset_z;
+    float depth_2 = (vertex_2.position.z * inverse_w_2 * transform.scale_z) + transform.offset_z;
+    attributes.depth = tri_plane(depth_0, depth_1, depth_2);
+    setup.min_depth = std::min({depth_0, depth_1, depth_2});
+    setup.max_depth = std::max({depth_0, depth_1, depth_2});
+    attributes.inverse_w = tri_plane(inverse_w_0, inverse_w_1, inverse_w_2);
+    for (uint32_t i = 0; i < attributes.varying_count; ++i) {
+        attributes.varyings[i] = tri_plane(vertex_0.varyings[i] * inverse_w_0, vertex_1.varyings[i] * inverse_w_1, vertex_2.varyings[i] * inverse_w_2);
+    }
+
+    return setup;
+}
+
+// blocks of depth bounds along one side of a tile
+constexpr uint32_t TILE_BLOCKS = TILE_SIZE / BUFFER_BLOCK_SIZE;
+static_assert(TILE_BLOCKS * TILE_BLOCKS <= 64, "tile blocks have to fit a 64-bit mask");
+
+bool Renderer::rasterizeTri(TriSetup& setup, uint32_t primitive, const PassDraw& draw, Tile& tile) {
+    DepthBuffer* depth_buffer = this->frame_buffer->getDepthBuffer();
+    uint32_t* covering = this->frame_buffer->getPrimitiveBuffer()->getData();
+    uint32_t sample_count = this->frame_buffer->getSampleCount();
+    size_t pitch = depth_buffer->getQuadPitch();
+    bool written = false;
+
+    uint32_t min_x = std::max(setup.min_x, tile.min_x);
+    uint32_t min_y = std::max(setup.min_y, tile.min_y);
+    uint32_t max_x = std::min(setup.max_x, tile.max_x);
+    uint32_t max_y = std::min(setup.max_y, tile.max_y);
+
+    const AttributeSetup& attributes = setup.attributes;
+
+    // hierarchical depth test of every block the tri touches, the depth plane is linear so its
+    // range over a block is spanned by the block corners, intersected with the vertex depth range,
+    // samples off the pixel centers widen the block by up to half a pixel
+    float epsilon = depth_buffer->getBoundsEpsilon();
+    float reach = sample_count > 1 ? 0.5f : 0.0f;
+    uint64_t visible_blocks = 0;
+    for (uint32_t block_y = min_y / BUFFER_BLOCK_SIZE; block_y <= max_y / BUFFER_BLOCK_SIZE; ++block_y) {
+        for (uint32_t block_x = min_x / BUFFER_BLOCK_SIZE; block_x <= max_x / BUFFER_BLOCK_SIZE; ++block_x) {
+            uint32_t block_min_x = std::max(block_x * BUFFER_BLOCK_SIZE, min_x);
+            uint32_t block_min_y = std::max(block_y * BUFFER_BLOCK_SIZE, min_y);
+            uint32_t block_max_x = std::min(((block_x + 1) * BUFFER_BLOCK_SIZE) - 1, max_x);
+            uint32_t block_max_y = std::min(((block_y + 1) * BUFFER_BLOCK_SIZE) - 1, max_y);
+
+            float corner_x0 = static_cast<float>(static_cast<int32_t>(block_min_x) - attributes.origin_x) - reach;
+            float corner_y0 = static_cast<float>(static_cast<int32_t>(block_min_y) - attributes.origin_y) - reach;
+            float corner_x1 = static_cast<float>(static_cast<int32_t>(block_max_x) - attributes.origin_x) + reach;
+            float corner_y1 = static_cast<float>(static_cast<int32_t>(block_max_y) - attributes.origin_y) + reach;
+            float corners[4] = {
+                evaluatePlane(attributes.depth, corner_x0, corner_y0),
+                evaluatePlane(attributes.depth, corner_x1, corner_y0),
+                evaluatePlane(attributes.depth, corner_x0, corner_y1),
+                evaluatePlane(attributes.depth, corner_x1, corner_y1)
+            };
+            float block_min_depth = std::max(std::min({corners[0], corners[1], corners[2], corners[3]}), setup.min_depth);
+            float block_max_depth = std::min(std::max({corners[0], corners[1], corners[2], corners[3]}), setup.max_depth);
+
+            DepthBounds bounds = depth_buffer->getBounds(block_min_x, block_min_y, block_max_x, block_max_y);
+            if (testDepthBounds(draw.depth_function, block_min_depth, block_max_depth, bounds, epsilon)) {
+                // a pending clear is only written out once a block is actually rasterized
+                depth_buffer->resolve(block_min_x, block_min_y, block_max_x, block_max_y);
+                uint32_t bit = ((block_y - (tile.min_y / BUFFER_BLOCK_SIZE)) * TILE_BLOCKS) + (block_x - (tile.min_x / BUFFER_BLOCK_SIZE));
+                visible_blocks |= 1ull << bit;
+            }
+        }
+    }
+
+    if (!visible_blocks) {
+        return false;
+    }
+
+    // walk 2x2 quads aligned to even coordinates, tiles start on even coordinates too
+    uint32_t quad_min_x = min_x & ~1u;
+    uint32_t quad_min_y = min_y & ~1u;
+
+    // edge and depth offsets of every sample from its pixel center, a and b of an edge are whole
+    // multiples of SUBPIXEL_ONE so the edge offsets of sample positions in sixteenths stay exact
+    const SamplePosition* sample_positions = getSamplePositions(sample_count);
+    Long4 sample_edges[MAX_SAMPLES][3];
+    float sample_depths[MAX_SAMPLES];
+    for (uint32_t sample = 0; sample < sample_count; ++sample) {
+        const SamplePosition& position = sample_positions[sample];
+        for (size_t k = 0; k < 3; ++k) {
+            const EdgeFunction& edge = setup.edges[k];
+            int64_t offset = (((edge.a / SUBPIXEL_ONE) * position.x) + ((edge.b / SUBPIXEL_ONE) * position.y)) * (SUBPIXEL_ONE / 16);
+            sample_edges[sample][k] = Long4::broadcast(offset);
+        }
+        sample_depths[sample] = ((attributes.depth.a * position.x) + (attributes.depth.b * position.y)) / 16.0f;
+    }
+
+    // edge values of the four quad lanes at the first quad, stepped incrementally afterwards
+    Long4 row[3];
+    Long4 step_x[3];
+    Long4 step_y[3];
+    for (size_t k = 0; k < 3; ++k) {
+        const EdgeFunction& edge = setup.edges[k];
+        int64_t e = (edge.a * quad_min_x) + (edge.b * quad_min_y) + edge.c;
+        row[k] = Long4::set(e, e + edge.a, e + edge.b, e + edge.a + edge.b);
+        step_x[k] = Long4::broadcast(2 * edge.a);
+        step_y[k] = Long4::broadcast(2 * edge.b);
+    }
+
+    for (uint32_t y = quad_min_y; y <= max_y; y += 2) {
+        // lanes above or below the clipped bounding box belong to other tiles or lie outside the frame buffer
+        uint32_t row_mask = 0xF;
+        if (y < min_y) {
+            row_mask &= 0xC;
+        }
+        if (y + 1 > max_y) {
+            row_mask &= 0x3;
+        }
+
+        Long4 e0 = row[0];
+        Long4 e1 = row[1];
+        Long4 e2 = row[2];
+
+        for (uint32_t x = quad_min_x; x <= max_x; x += 2) {
+            uint32_t mask = row_mask;
+            if (x < min_x) {
+                mask &= 0xA;
+            }
+            if (x + 1 > max_x) {
+                mask &= 0x5;
+            }
+
+            uint32_t bit = (((y - tile.min_y) / BUFFER_BLOCK_SIZE) * TILE_BLOCKS) + ((x - tile.min_x) / BUFFER_BLOCK_SIZE);
+            if (!(visible_blocks & (1ull << bit))) {
+                mask = 0;
+            }
+
+            // the sign bit of the combined value is set if any edge function is negative
+            if (sample_count == 1) {
+                mask &= ~(e0 | e1 | e2).signMask();
+                if (mask) {
+                    float depths[4];
+                    evaluatePlaneQuad(attributes.depth, static_cast<float>(static_cast<int32_t>(x) - attributes.origin_x), static_cast<float>(static_cast<int32_t>(y) - attributes.origin_y)).store(depths);
+
+                    // early depth test, occluded fragments never reach the fragment shader
+                    size_t base = depth_buffer->getIndex(Vector2u(x, y));
+                    for (uint32_t lane = 0; lane < 4; ++lane) {
+                        if (!(mask & (1u << lane))) {
+                            continue;
+                        }
+
+                        size_t index = base + ((lane >> 1) * pitch) + (lane & 1);
+                        if (depth_buffer->test(index, 0, draw.depth_function, depths[lane], draw.depth_write)) {
+                            covering[index] = primitive;
+                            tile.cover(x, y);
+                            written = true;
+                        }
+                    }
+                }
+            } else if (mask) {
+                uint32_t sample_masks[4] = {0, 0, 0, 0};
+                uint32_t covered = 0;
+                for (uint32_t sample = 0; sample < sample_count; ++sample) {
+                    uint32_t lanes = mask & ~((e0 + sample_edges[sample][0]) | (e1 + sample_edges[sample][1]) | (e2 + sample_edges[sample][2])).signMask();
+                    covered |= lanes;
+                    for (; lanes; lanes &= lanes - 1) {
+                        sample_masks[std::countr_zero(lanes)] |= 1u << sample;
+                    }
+                }
+
+                if (covered) {
+                    float depths[4];
+                    evaluatePlaneQuad(attributes.depth, static_cast<float>(static_cast<int32_t>(x) - attributes.origin_x), static_cast<float>(static_cast<int32_t>(y) - attributes.origin_y)).store(depths);
+
+                    // early depth test of every covered sample, occluded samples never reach the fragment shader
+                    size_t base = depth_buffer->getIndex(Vector2u(x, y));
+                    for (; covered; covered &= covered - 1) {
+                        uint32_t lane = std::countr_zero(covered);
+                        size_t index = base + ((lane >> 1) * pitch) + (lane & 1);
+                        for (uint32_t samples = sample_masks[lane]; samples; samples &= samples - 1) {
+                            uint32_t sample = std::countr_zero(samples);
+                            if (depth_buffer->test(index, sample, draw.depth_function, depths[lane] + sample_depths[sample], draw.depth_write)) {
+                                covering[(index * sample_count) + sample] = primitive;
+                                tile.cover(x, y);
+                                written = true;
+                            }
+                        }
+                    }
+                }
+            }
+
+            e0 = e0 + step_x[0];
+            e1 = e1 + step_x[1];
+            e2 = e2 + step_x[2];
+        }
+
+        row[0] = row[0] + step_y[0];
+        row[1] = row[1] + step_y[1];
+        row[2] = row[2] + step_y[2];
+    }
 
-    this->shader->runFragment();
+    return written;
 }
 
 } // namespace apparition
\ No newline at end of file
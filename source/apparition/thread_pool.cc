@@ -0,0 +1,129 @@
+// codeshaunted - apparition
+// source/apparition/thread_pool.cc
+// contains thread pool definitions
+// Copyright 2024 codeshaunted
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org / licenses / LICENSE - 2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissionsand
+// limitations under the License.
+
+#include <stdexcept>
+
+#include "thread_pool.hh"
+
+namespace apparition {
+
+ThreadPool::ThreadPool(size_t thread_count) {
+    if (thread_count == 0) {
+        throw std::invalid_argument("'thread_count' must be at least 1");
+    }
+
+    this->job = nullptr;
+    this->task_count = 0;
+    this->next_task = 0;
+    this->active_workers = 0;
+    this->generation = 0;
+    this->stopping = false;
+
+    for (size_t worker = 1; worker < thread_count; ++worker) {
+        this->threads.emplace_back(&ThreadPool::work, this, worker);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->start_condition.notify_all();
+
+    for (std::thread& thread : this->threads) {
+        thread.join();
+    }
+}
+
+size_t ThreadPool::getThreadCount() {
+    return this->threads.size() + 1;
+}
+
+void ThreadPool::run(size_t task_count, const std::function<void(size_t task, size_t worker)>& task) {
+    if (this->threads.empty()) {
+        for (size_t i = 0; i < task_count; ++i) {
+            task(i, 0);
+        }
+
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->job = &task;
+        this->task_count = task_count;
+        this->next_task = 0;
+        this->active_workers = this->threads.size();
+        this->exception = nullptr;
+        ++this->generation;
+    }
+    this->start_condition.notify_all();
+
+    this->drain(0);
+
+    std::exception_ptr exception;
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->done_condition.wait(lock, [this] { return this->active_workers == 0; });
+        this->job = nullptr;
+        exception = this->exception;
+    }
+
+    if (exception) {
+        std::rethrow_exception(exception);
+    }
+}
+
+void ThreadPool::work(size_t worker) {
+    uint64_t seen_generation = 0;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->start_condition.wait(lock, [this, seen_generation] { return this->stopping || this->generation != seen_generation; });
+            if (this->stopping) {
+                return;
+            }
+            seen_generation = this->generation;
+        }
+
+        this->drain(worker);
+
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if (--this->active_workers == 0) {
+                this->done_condition.notify_one();
+            }
+        }
+    }
+}
+
+void ThreadPool::drain(size_t worker) {
+    for (size_t i = this->next_task.fetch_add(1); i < this->task_count; i = this->next_task.fetch_add(1)) {
+        try {
+            (*this->job)(i, worker);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if (!this->exception) {
+                this->exception = std::current_exception();
+            }
+        }
+    }
+}
+
+} // namespace apparition
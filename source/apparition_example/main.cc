@@ -15,106 +15,50 @@
 // See the License for the specific language governing permissionsand
 // limitations under the License.
 
+#include <algorithm>
 #include <iostream>
-#include <fstream>
+#include <thread>
+#include <vector>
 
+#include "image.hh"
 #include "renderer.hh"
-#include "shader.hh"
 
 using namespace apparition;
 
-// Define the TGA header structure
-#pragma pack(push, 1)
-struct TGAHeader {
-    uint8_t id_length;
-    uint8_t color_map_type;
-    uint8_t image_type;
-    uint16_t color_map_origin;
-    uint16_t color_map_length;
-    uint8_t color_map_depth;
-    uint16_t x_origin;
-    uint16_t y_origin;
-    uint16_t width;
-    uint16_t height;
-    uint8_t bits_per_pixel;
-    uint8_t image_descriptor;
-};
-#pragma pack(pop)
-
-void saveFrameBufferToTGA(const char* filename, ColorBuffer* colorBuffer) {
-    if (!colorBuffer) {
-        std::cerr << "Color buffer is nullptr." << std::endl;
-        return;
+struct MyShader {
+    void vertex(Vertex& /* vertex */) {
     }
 
-    std::ofstream file(filename, std::ios::binary);
-    if (!file.is_open()) {
-        std::cerr << "Failed to open file for writing: " << filename << std::endl;
-        return;
-    }
-
-    // Write the TGA header
-    TGAHeader header;
-    std::memset(&header, 0, sizeof(TGAHeader));
-    header.image_type = 2; // Uncompressed true-color image
-    header.width = static_cast<uint16_t>(colorBuffer->getDimensions().x);
-    header.height = static_cast<uint16_t>(colorBuffer->getDimensions().y);
-    header.bits_per_pixel = 32; // 4 bytes per pixel (RGBA)
-    file.write(reinterpret_cast<char*>(&header), sizeof(TGAHeader));
-
-    // Write pixel data (RGBA) to the file
-    const Vector2u dimensions = colorBuffer->getDimensions();
-    const Vector4f* pixels = colorBuffer->getData();
-    for (size_t y = 0; y < dimensions.y; ++y) {
-        for (size_t x = 0; x < dimensions.x; ++x) {
-            const Vector4f& pixel = pixels[y * dimensions.x + x];
-            // TGA format stores pixel data in BGRA order
-            const uint8_t rgba[4] = {
-                static_cast<uint8_t>(pixel.b * 255), // Blue
-                static_cast<uint8_t>(pixel.g * 255), // Green
-                static_cast<uint8_t>(pixel.r * 255), // Red
-                static_cast<uint8_t>(pixel.a * 255)  // Alpha
-            };
-            file.write(reinterpret_cast<const char*>(&rgba), sizeof(rgba));
-        }
+    Vector4f fragment(const FragmentInput& fragment) {
+        return Vector4f(fragment.varyings[0], fragment.varyings[1], fragment.varyings[2], fragment.varyings[3]);
     }
-
-    file.close();
-    std::cout << "TGA file saved: " << filename << std::endl;
-}
-
-class MyShader : public Shader {
-    public:
-        void runVertex() override {
-        }
-
-        void runFragment() override {
-            this->out_fragment_color = this->varying_vertex_color;
-        }
 };
 
 int main() {
     Vector2u dimensions(800, 600);
-    FrameBuffer frame_buffer(dimensions);
+    FrameBuffer frame_buffer(dimensions, BufferLayout::TILED);
     std::vector<Vertex> vertex_buffer{
-        Vertex(Vector4f(0.0f, 0.0f, 0.0f, 0.0f), Vector4f(0.0f, 0.0f, 1.0f, 1.0f)),
-        Vertex(Vector4f(0.5f, 1.0f, 0.0f, 0.0f), Vector4f(1.0f, 0.0f, 0.0f, 1.0f)),
-        Vertex(Vector4f(1.0f, 0.0f, 0.0f, 0.0f), Vector4f(0.0f, 1.0f, 0.0f, 1.0f)),
-        Vertex(Vector4f(1.0f, 1.0f, 0.0f, 0.0f), Vector4f(0.0f, 0.0f, 1.0f, 1.0f))
+        Vertex{Vector4f(-1.0f, -1.0f, 0.0f, 1.0f), {0.0f, 0.0f, 1.0f, 1.0f}},
+        Vertex{Vector4f(0.0f, 1.0f, 0.0f, 1.0f), {1.0f, 0.0f, 0.0f, 1.0f}},
+        Vertex{Vector4f(1.0f, -1.0f, 0.0f, 1.0f), {0.0f, 1.0f, 0.0f, 1.0f}},
+        Vertex{Vector4f(1.0f, 1.0f, 0.0f, 1.0f), {0.0f, 0.0f, 1.0f, 1.0f}}
     };
-    std::vector<size_t> index_buffer{
+    std::vector<uint16_t> index_buffer{
         0, 1, 2, 1, 2, 3
     };
     MyShader shader;
 
     Renderer renderer;
+    renderer.setThreadCount(std::max(1u, std::thread::hardware_concurrency()));
     renderer.bindFrameBuffer(&frame_buffer);
     renderer.bindVertexBuffer(&vertex_buffer);
     renderer.bindIndexBuffer(&index_buffer);
-    renderer.bindShader(&shader);
-    renderer.drawTris();
 
-    saveFrameBufferToTGA("output.tga", frame_buffer.getColorBuffer());
+    frame_buffer.clear(Vector4f(0.0f, 0.0f, 0.0f, 0.0f));
+    renderer.drawTris(shader);
+
+    saveImage("output.tga", frame_buffer.getColorBuffer(), ImageFormat::TGA);
+    std::cout << "TGA file saved: output.tga" << std::endl;
 
     return 0;
 }
\ No newline at end of file